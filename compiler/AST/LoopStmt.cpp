@@ -21,9 +21,10 @@
 
 LoopStmt::LoopStmt(BlockStmt* initBody) : BlockStmt(initBody)
 {
-  mBreakLabel       = 0;
-  mContinueLabel    = 0;
-  mOrderIndependent = false;
+  mBreakLabel         = 0;
+  mContinueLabel      = 0;
+  mOrderIndependent   = false;
+  mAggregateRemoteOps = false;
 }
 
 LoopStmt::~LoopStmt()
@@ -66,6 +67,16 @@ void LoopStmt::orderIndependentSet(bool orderIndependent)
   mOrderIndependent = orderIndependent;
 }
 
+bool LoopStmt::aggregatesRemoteOps() const
+{
+  return mAggregateRemoteOps;
+}
+
+void LoopStmt::aggregateRemoteOpsSet(bool aggregateRemoteOps)
+{
+  mAggregateRemoteOps = aggregateRemoteOps;
+}
+
 LoopStmt* LoopStmt::findEnclosingLoop(Expr* expr)
 {
   LoopStmt* retval = NULL;
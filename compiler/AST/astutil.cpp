@@ -897,13 +897,14 @@ Symbol* getSvecSymbol(CallExpr* call) {
   AggregateType* tuple = toAggregateType(type);
   SymExpr* fieldVal = toSymExpr(call->get(2));
   VarSymbol* fieldSym = toVarSymbol(fieldVal->symbol());
-  if (fieldSym) {
+  if (fieldSym && fieldSym->immediate) {
     int immediateVal = fieldSym->immediate->int_value();
 
     INT_ASSERT(immediateVal >= 1 && immediateVal <= tuple->fields.length);
     return tuple->getField(immediateVal);
   } else {
-    // GET_SVEC_MEMBER(p, i), where p is a star tuple
+    // GET_SVEC_MEMBER(p, i), where p is a star tuple and i is not a
+    // constant, e.g. a formal or a local after inlining
     return NULL;
   }
 }
@@ -943,3 +944,137 @@ void collectUsedFnSymbols(BaseAST* ast, std::set<FnSymbol*>& fnSymbols) {
     }
   }
 }
+
+
+/*
+ * Does rhs produce an instance that has just been allocated, either
+ * directly or by casting a fresh allocation to its class type?
+ */
+static bool isFreshInstance(Expr* rhs, std::set<Symbol*>& freshInstances) {
+  if (CallExpr* call = toCallExpr(rhs)) {
+    if (call->isResolved() == gChplHereAlloc) {
+      return true;
+    }
+    if (call->isPrimitive(PRIM_CAST)) {
+      if (SymExpr* symExpr = toSymExpr(call->get(2))) {
+        return freshInstances.count(symExpr->symbol()) == 1;
+      }
+    }
+  }
+  return false;
+}
+
+
+/*
+ * Collect the variables that only ever hold a freshly allocated instance.
+ * Once a constructor has been inlined its field initializations are set
+ * members through such a variable, in whatever function created the
+ * instance.
+ */
+static void collectFreshInstances(std::set<Symbol*>& freshInstances) {
+  bool changed = true;
+
+  // find the variables that are assigned a fresh instance
+  while (changed) {
+    changed = false;
+
+    forv_Vec(CallExpr, call, gCallExprs) {
+      if (call->isPrimitive(PRIM_MOVE) && call->parentSymbol) {
+        SymExpr* lhs = toSymExpr(call->get(1));
+
+        if (lhs && isVarSymbol(lhs->symbol()) &&
+            freshInstances.count(lhs->symbol()) == 0 &&
+            isFreshInstance(call->get(2), freshInstances)) {
+          freshInstances.insert(lhs->symbol());
+          changed = true;
+        }
+      }
+    }
+  }
+
+  // and drop the ones that are assigned anything else
+  changed = true;
+
+  while (changed) {
+    changed = false;
+
+    forv_Vec(SymExpr, symExpr, gSymExprs) {
+      if (symExpr->parentSymbol &&
+          freshInstances.count(symExpr->symbol()) == 1 &&
+          (isDefAndOrUse(symExpr) & 1)) {
+        CallExpr* call = toCallExpr(symExpr->parentExpr);
+
+        if (call == NULL                     ||
+            !call->isPrimitive(PRIM_MOVE)    ||
+            call->get(1) != symExpr          ||
+            !isFreshInstance(call->get(2), freshInstances)) {
+          freshInstances.erase(symExpr->symbol());
+          changed = true;
+        }
+      }
+    }
+  }
+}
+
+
+/*
+ * Find the fields of classes that are written only while an instance is
+ * being constructed: every PRIM_SET_MEMBER of the field sets the instance of
+ * the enclosing constructor or a freshly allocated instance, and the field's
+ * address is only taken (PRIM_GET_MEMBER) by a constructor for its own
+ * instance or by the accessor of a const field. Once an instance is visible
+ * outside of its construction these fields can not change.
+ */
+void collectWriteOnceFields(std::set<Symbol*>& writeOnceFields) {
+  std::set<Symbol*> freshInstances;
+  std::set<Symbol*> writtenFields;
+
+  collectFreshInstances(freshInstances);
+
+  forv_Vec(CallExpr, call, gCallExprs) {
+    if (call->parentSymbol == NULL) {
+      continue;
+    }
+
+    if (call->isPrimitive(PRIM_SET_MEMBER) ||
+        call->isPrimitive(PRIM_GET_MEMBER)) {
+      FnSymbol* fn   = call->getFunction();
+      SymExpr*  base = toSymExpr(call->get(1));
+
+      // a constructor initializing its own instance
+      if (fn && (fn->hasFlag(FLAG_CONSTRUCTOR) ||
+                 fn->hasFlag(FLAG_TYPE_CONSTRUCTOR)) &&
+          base && base->symbol() == fn->_this) {
+        continue;
+      }
+
+      if (call->isPrimitive(PRIM_SET_MEMBER) &&
+          base && freshInstances.count(base->symbol()) == 1) {
+        continue;
+      }
+
+      // an accessor returning a reference that can not be written through
+      if (call->isPrimitive(PRIM_GET_MEMBER) &&
+          fn && fn->hasFlag(FLAG_FIELD_ACCESSOR) &&
+          fn->hasFlag(FLAG_REF_TO_CONST)) {
+        continue;
+      }
+
+      if (SymExpr* field = toSymExpr(call->get(2))) {
+        writtenFields.insert(field->symbol());
+      }
+    }
+  }
+
+  forv_Vec(TypeSymbol, ts, gTypeSymbols) {
+    if (AggregateType* ct = toAggregateType(ts->type)) {
+      if (ct->isClass()) {
+        for_fields(field, ct) {
+          if (writtenFields.count(field) == 0) {
+            writeOnceFields.insert(field);
+          }
+        }
+      }
+    }
+  }
+}
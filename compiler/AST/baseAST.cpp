@@ -286,6 +286,118 @@ const std::string BaseAST::tabText = "   ";
 BaseAST::~BaseAST() {
 }
 
+/************************************ | *************************************
+*                                                                           *
+* AST nodes are allocated from per-size-class arenas rather than with a     *
+* separate malloc each.  An arena hands out nodes of one rounded size from  *
+* large slabs; the nodes that cleanAst() deletes between passes are kept on *
+* the arena's free list and reused by the following passes.  This avoids   *
+* the per-allocation header and most of the fragmentation of the general    *
+* heap.  Nodes larger than the biggest size class use operator new.         *
+*                                                                           *
+* The slabs are never returned to the system: the AST stays large until the *
+* end of compilation.                                                       *
+*                                                                           *
+************************************* | ************************************/
+
+static const size_t kAstAlign      = sizeof(void*);
+static const size_t kAstMaxSize    = 512;
+static const size_t kAstSlabSize   = 64 * 1024;
+static const size_t kAstNumClasses = kAstMaxSize / kAstAlign;
+
+struct AstFreeNode {
+  AstFreeNode* next;
+};
+
+struct AstArena {
+  AstFreeNode* freeList;
+  char*        slabNext;   // first unused byte of the current slab
+  char*        slabEnd;
+};
+
+static AstArena astArenas[kAstNumClasses];
+
+static size_t astBytesLive     = 0;
+static size_t astBytesPeak     = 0;
+static size_t astBytesReserved = 0;
+
+static size_t astSizeClass(size_t size) {
+  return (size + kAstAlign - 1) / kAstAlign - 1;
+}
+
+void* BaseAST::operator new(size_t size) {
+  void* retval = NULL;
+
+  astBytesLive += size;
+
+  if (astBytesLive > astBytesPeak)
+    astBytesPeak = astBytesLive;
+
+  if (size > kAstMaxSize) {
+    astBytesReserved += size;
+    retval            = ::operator new(size);
+
+  } else {
+    AstArena* arena     = &astArenas[astSizeClass(size)];
+    size_t    allocSize = (astSizeClass(size) + 1) * kAstAlign;
+
+    if (arena->freeList != NULL) {
+      retval          = arena->freeList;
+      arena->freeList = arena->freeList->next;
+
+    } else {
+      if (arena->slabNext + allocSize > arena->slabEnd) {
+        arena->slabNext   = (char*) ::operator new(kAstSlabSize);
+        arena->slabEnd    = arena->slabNext + kAstSlabSize;
+        astBytesReserved += kAstSlabSize;
+      }
+
+      retval           = arena->slabNext;
+      arena->slabNext += allocSize;
+    }
+  }
+
+  return retval;
+}
+
+void BaseAST::operator delete(void* ptr, size_t size) {
+  if (ptr == NULL)
+    return;
+
+  astBytesLive -= size;
+
+  if (size > kAstMaxSize) {
+    astBytesReserved -= size;
+    ::operator delete(ptr);
+
+  } else {
+    AstArena*    arena = &astArenas[astSizeClass(size)];
+    AstFreeNode* node  = (AstFreeNode*) ptr;
+
+    node->next      = arena->freeList;
+    arena->freeList = node;
+  }
+}
+
+//
+// Print the peak number of bytes held by AST nodes during 'pass', the
+// number still held once its dead nodes have been cleaned, and the size
+// of the arenas.  Called after each pass under --print-ast-memory.
+//
+void printAstMemory(const char* pass) {
+  fprintf(stderr, "%-32s peak %9zuK  live %9zuK  arenas %9zuK\n",
+          pass,
+          astBytesPeak     / 1024,
+          astBytesLive     / 1024,
+          astBytesReserved / 1024);
+
+  astBytesPeak = astBytesLive;
+}
+
+size_t astMemoryInUse() {
+  return astBytesLive;
+}
+
 int BaseAST::linenum() const {
   return astloc.lineno;
 }
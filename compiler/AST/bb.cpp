@@ -22,6 +22,7 @@
 #include "astutil.h"
 #include "bitVec.h"
 #include "CForLoop.h"
+#include "compilerTrace.h"
 #include "DoWhileStmt.h"
 #include "ForLoop.h"
 #include "stlUtil.h"
@@ -526,62 +527,41 @@ void BasicBlock::buildLocalsVectorMap(FnSymbol*          fn,
 
 
 //#define DEBUG_FLOW
-void BasicBlock::backwardFlowAnalysis(FnSymbol*             fn,
-                                      std::vector<BitVec*>& GEN,
-                                      std::vector<BitVec*>& KILL,
-                                      std::vector<BitVec*>& IN,
-                                      std::vector<BitVec*>& OUT) {
-  bool iterate = true;
-
-  while (iterate) {
-    int i = 0;
-
-    iterate = false;
-
-    for_vector(BasicBlock, bb, *fn->basicBlocks) {
-      for (size_t j = 0; j < IN[i]->ndata; j++) {
-        unsigned int new_in  = (OUT[i]->data[j] & ~KILL[i]->data[j]) | GEN[i]->data[j];
-        unsigned int new_out = 0;
-
-        if (new_in != IN[i]->data[j]) {
-          IN[i]->data[j] = new_in;
-          iterate = true;
-        }
-
-        for_vector(BasicBlock, bbout, bb->outs) {
-          new_out = new_out | IN[bbout->id]->data[j];
-        }
-
-        if (new_out != OUT[i]->data[j]) {
-          OUT[i]->data[j] = new_out;
-          iterate = true;
-        }
-      }
 
-      i++;
-    }
-#ifdef DEBUG_FLOW
-    printf("IN\n");  printBitVectorSets(IN);
-    printf("OUT\n"); printBitVectorSets(OUT);
-#endif
-  }
-}
-
-
-void BasicBlock::forwardFlowAnalysis(FnSymbol*             fn,
-                                     std::vector<BitVec*>& GEN,
-                                     std::vector<BitVec*>& KILL,
-                                     std::vector<BitVec*>& IN,
-                                     std::vector<BitVec*>& OUT,
-                                     bool                  intersect) {
-  size_t           nbbq = fn->basicBlocks->size(); // size of bb queue
-  std::vector<int> bbq;
-  BitVec           bbs(nbbq);
-  int              iq = -1;
-  int              nq = nbbq - 1;
+static TraceCounter flowBlockVisits("dataflow block visits");
+
+//
+// The forward and the backward analyses share one worklist solver.  For a
+// backward problem the roles of IN and OUT, and of the predecessors and the
+// successors of a block, are exchanged:
+//
+//   before(i) = meet of after(p) over the predecessors p of block i
+//   after(i)  = (before(i) - KILL(i)) | GEN(i)
+//
+// Every block is queued once, in order for a forward problem and in reverse
+// order for a backward one.  After that a block is only queued again when
+// after() of one of its predecessors changes.  The sets are combined a
+// 64-bit word at a time.  A block without predecessors keeps the before()
+// set that the caller initialized.
+//
+static void flowAnalysis(FnSymbol*             fn,
+                         std::vector<BitVec*>& GEN,
+                         std::vector<BitVec*>& KILL,
+                         std::vector<BitVec*>& IN,
+                         std::vector<BitVec*>& OUT,
+                         bool                  forward,
+                         bool                  intersect) {
+  std::vector<BitVec*>& before = (forward) ? IN  : OUT;
+  std::vector<BitVec*>& after  = (forward) ? OUT : IN;
+
+  size_t                nbbq   = fn->basicBlocks->size(); // size of bb queue
+  std::vector<int>      bbq;
+  BitVec                bbs(nbbq);
+  int                   iq     = -1;
+  int                   nq     = nbbq - 1;
 
   for (size_t i = 0; i < nbbq; i++) {
-    bbq.push_back(i);
+    bbq.push_back((forward) ? i : nbbq - 1 - i);
     bbs.set(i);
   }
 
@@ -592,6 +572,8 @@ void BasicBlock::forwardFlowAnalysis(FnSymbol*             fn,
 
     bbs.unset(i);
 
+    flowBlockVisits.Add();
+
 #ifdef DEBUG_FLOW
     if (iq == 0) {
       printf("IN\n");  printBitVectorSets(IN);
@@ -599,46 +581,79 @@ void BasicBlock::forwardFlowAnalysis(FnSymbol*             fn,
     }
 #endif
 
-    BasicBlock* bb     = (*fn->basicBlocks)[i];
-    bool        change = false;
+    BasicBlock*               bb    = (*fn->basicBlocks)[i];
+    std::vector<BasicBlock*>& preds = (forward) ? bb->ins  : bb->outs;
+    std::vector<BasicBlock*>& succs = (forward) ? bb->outs : bb->ins;
+
+    uint64_t*                 in    = before[i]->data;
+    uint64_t*                 out   = after[i]->data;
+    const uint64_t*           gen   = GEN[i]->data;
+    const uint64_t*           kill  = KILL[i]->data;
+    size_t                    ndata = before[i]->ndata;
+    bool                      change = false;
 
-    for (size_t j = 0; j < IN[i]->ndata; j++) {
-      if (bb->ins.size() > 0) {
-        unsigned int new_in = (intersect) ? (unsigned int) (-1) : 0;
+    if (preds.size() > 0) {
+      for (size_t j = 0; j < ndata; j++) {
+        uint64_t new_in = after[preds[0]->id]->data[j];
 
-        for_vector(BasicBlock, bbin, bb->ins) {
+        for (size_t k = 1; k < preds.size(); k++) {
           if (intersect)
-            new_in &= OUT[bbin->id]->data[j];
+            new_in &= after[preds[k]->id]->data[j];
           else
-            new_in |= OUT[bbin->id]->data[j];
+            new_in |= after[preds[k]->id]->data[j];
         }
 
-        if (new_in != IN[i]->data[j]) {
-          IN[i]->data[j] = new_in;
-          change         = true;
-        }
+        in[j] = new_in;
       }
+    }
 
-      unsigned int new_out = (IN[i]->data[j] & ~KILL[i]->data[j]) | GEN[i]->data[j];
+    for (size_t j = 0; j < ndata; j++) {
+      uint64_t new_out = (in[j] & ~kill[j]) | gen[j];
 
-      if (new_out != OUT[i]->data[j]) {
-        OUT[i]->data[j] = new_out;
-        change          = true;
+      if (new_out != out[j]) {
+        out[j] = new_out;
+        change = true;
       }
     }
 
     if (change) {
-      for_vector(BasicBlock, bbout, bb->outs) {
-        if (!bbs.get(bbout->id)) {
+      for_vector(BasicBlock, succ, succs) {
+        if (!bbs.get(succ->id)) {
           nq      = (nq + 1) % nbbq;
 
-          bbs.set(bbout->id);
+          bbs.set(succ->id);
 
-          bbq[nq] = bbout->id;
+          bbq[nq] = succ->id;
         }
       }
     }
   }
+
+#ifdef DEBUG_FLOW
+  printf("IN\n");  printBitVectorSets(IN);
+  printf("OUT\n"); printBitVectorSets(OUT);
+#endif
+}
+
+void BasicBlock::backwardFlowAnalysis(FnSymbol*             fn,
+                                      std::vector<BitVec*>& GEN,
+                                      std::vector<BitVec*>& KILL,
+                                      std::vector<BitVec*>& IN,
+                                      std::vector<BitVec*>& OUT) {
+  TraceRegion region("backwardFlowAnalysis", fn->name);
+
+  flowAnalysis(fn, GEN, KILL, IN, OUT, false, false);
+}
+
+void BasicBlock::forwardFlowAnalysis(FnSymbol*             fn,
+                                     std::vector<BitVec*>& GEN,
+                                     std::vector<BitVec*>& KILL,
+                                     std::vector<BitVec*>& IN,
+                                     std::vector<BitVec*>& OUT,
+                                     bool                  intersect) {
+  TraceRegion region("forwardFlowAnalysis", fn->name);
+
+  flowAnalysis(fn, GEN, KILL, IN, OUT, true, intersect);
 }
 
 void BasicBlock::printBasicBlocks(FnSymbol* fn) {
@@ -1008,7 +1008,8 @@ void checkEmptyPartialCopyFnMap() {
  * and retExprType members.  In addition, the return symbol needs to be made
  * available despite the fact that we have skipped copying the body.
  *
- * \param map Map from symbols in the old function to symbols in the new one
+ * \param map Map from symbols in the old function to symbols in the new one;
+ *            it is moved into the new function's PartialCopyData
  */
 FnSymbol* FnSymbol::partialCopy(SymbolMap* map) {
   FnSymbol* newFn = this->copyInnerCore(map);
@@ -1086,8 +1087,10 @@ FnSymbol* FnSymbol::partialCopy(SymbolMap* map) {
   // Update symbols in the sub-AST as is appropriate.
   update_symbols(newFn, map);
 
-  // Copy over the partialCopyMap, to be used later in finalizeCopy.
-  pci.partialCopyMap.copy(*map);
+  // Hand the map over to the partialCopyMap, to be used later in
+  // finalizeCopy.  This leaves 'map' empty; callers that still need the
+  // substitutions made here read them from getPartialCopyInfo(newFn).
+  pci.partialCopyMap.move(*map);
 
   return newFn;
 }
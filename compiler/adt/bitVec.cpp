@@ -21,7 +21,7 @@
 
 #include <cstdlib>
 
-#define TYPE unsigned
+#define TYPE uint64_t
 
 BitVec::BitVec(size_t in_size) {
   if (in_size == 0) {
@@ -70,7 +70,7 @@ bool BitVec::get(size_t i) const {
   size_t j = i / (sizeof(TYPE) << 3);
   size_t k = i - j * (sizeof(TYPE) << 3);
 
-  return data[j] & (1 << k);
+  return data[j] & (((TYPE) 1) << k);
 }
 
 
@@ -78,7 +78,7 @@ void BitVec::unset(size_t i) {
   size_t j = i / (sizeof(TYPE) << 3);
   size_t k = i - j * (sizeof(TYPE) << 3);
 
-  data[j] &= ((TYPE)-1) - (1 << k);
+  data[j] &= ~(((TYPE) 1) << k);
 }
 
 
@@ -140,7 +140,7 @@ void BitVec::set(size_t i) {
   size_t j = i / (sizeof(TYPE) << 3);
   size_t k = i - j * (sizeof(TYPE) << 3);
 
-  data[j] |= 1 << k;
+  data[j] |= ((TYPE) 1) << k;
 }
 
 
@@ -154,7 +154,7 @@ void BitVec::reset(size_t i) {
   size_t j = i / (sizeof(TYPE) << 3);
   size_t k = i - j * (sizeof(TYPE) << 3);
 
-  data[j] &= ((size_t)-1) - (1 << k);
+  data[j] &= ~(((TYPE) 1) << k);
 }
 
 
@@ -168,10 +168,10 @@ void BitVec::copy(size_t i, bool value) {
   size_t j = i / (sizeof(TYPE) << 3);
   size_t k = i - j * (sizeof(TYPE) << 3);
 
-  data[j] &= ~(1 << k);
+  data[j] &= ~(((TYPE) 1) << k);
 
   if (value)
-    data[j] |= (1 << k);
+    data[j] |= (((TYPE) 1) << k);
 }
 
 
@@ -185,30 +185,15 @@ void BitVec::flip(size_t i) {
   size_t j = i / (sizeof(TYPE)<<3);
   size_t k = i - j*(sizeof(TYPE)<<3);
 
-  data[j] ^= 1 << k;
+  data[j] ^= ((TYPE) 1) << k;
 }
 
 
-/*
- * The current use of this function expects there to be almost no 1's
- * in which case this algorithm is the most efficient instead of an
- * implementation that uses divide and conquer shifting and counting with
- * hex manipulation (I have no idea what the name of that bit counting
- * algorithm is)
- */
 size_t BitVec::count() const {
   size_t count = 0;
 
-  for (size_t i = 0; i < ndata; i++) {
-    size_t localCount = 0;
-    size_t x          = data[i];
-
-    for (localCount = 0; x; localCount++) {
-      x &= x - 1;
-    }
-
-    count += localCount;
-  }
+  for (size_t i = 0; i < ndata; i++)
+    count += __builtin_popcountll(data[i]);
 
   return count;
 }
@@ -223,7 +208,7 @@ bool BitVec::test(size_t i) const {
   size_t j = i / (sizeof(TYPE) << 3);
   size_t k = i - j * (sizeof(TYPE) << 3);
 
-  return data[j] & (1 << k);
+  return data[j] & (((TYPE) 1) << k);
 }
 
 
@@ -0,0 +1,226 @@
+/*
+ * Copyright 2004-2016 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// Micro-benchmark for the pointer maps in map.h.  Build and run with
+//
+//   make mapBench
+//   $CHPL_HOME/build/compiler/.../adt/mapBench [rounds]
+//
+// Each round replays the SymbolMap traffic of copying a set of function
+// bodies: a copy() puts one entry per symbol defined in the body, looks
+// each of them up from the uses that update_symbols() rewrites, and
+// update_symbols() or the caller walks the map with form_Map.  Most
+// bodies define a handful of symbols; a few module-level copies define
+// thousands.  The keys are heap pointers of AST node size, as in the
+// compiler.
+//
+// Map is compared with the Vec set based map it replaced (LegacyMap),
+// with HashMap and with ChainHashMap.
+//
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "map.h"
+#include "timer.h"
+
+struct Node {
+  char payload[96];
+};
+
+typedef MapElem<Node*,Node*> NodeMapElem;
+
+class PtrHashFns {
+ public:
+  static unsigned int hash(Node* a) { return (unsigned int)(uintptr_t)a; }
+  static int equal(Node* a, Node* b) { return a == b; }
+};
+
+//
+// The Map implementation before it was changed to open addressing: a Vec
+// set of MapElems hashed modulo a prime with a bounded quadratic probe.
+//
+class LegacyMap : public Vec<NodeMapElem> {
+ public:
+  NodeMapElem* put(Node* akey, Node* avalue) {
+    NodeMapElem  e(akey, avalue);
+    NodeMapElem* x = set_in(e);
+    if (x) {
+      x->value = avalue;
+      return x;
+    } else
+      return set_add(e);
+  }
+
+  Node* get(Node* akey) {
+    NodeMapElem  e(akey, (Node*)0);
+    NodeMapElem* x = set_in(e);
+    return (x) ? x->value : 0;
+  }
+};
+
+static const int kNumBodies     = 2000;
+static const int kUsesPerSymbol = 3;
+
+static int    bodySizes[kNumBodies];
+static Node** bodySymbols[kNumBodies];
+static Node*  newSymbol;
+
+static void buildWorkload() {
+  int total = 0;
+
+  srand(1234);
+
+  for (int i = 0; i < kNumBodies; i++) {
+    int r = rand() % 100;
+
+    if (r < 70)
+      bodySizes[i] = 1 + rand() % 8;
+    else if (r < 98)
+      bodySizes[i] = 9 + rand() % 200;
+    else
+      bodySizes[i] = 1000 + rand() % 4000;
+
+    total += bodySizes[i];
+  }
+
+  //
+  // Symbols are interleaved with the expressions of the body, so leave a
+  // few nodes between consecutive symbols.
+  //
+  Node* nodes = new Node[total * 8];
+
+  for (int i = 0, next = 0; i < kNumBodies; i++) {
+    bodySymbols[i] = new Node*[bodySizes[i]];
+
+    for (int j = 0; j < bodySizes[i]; j++) {
+      bodySymbols[i][j] = &nodes[next];
+      next             += 1 + rand() % 7;
+    }
+  }
+
+  newSymbol = new Node;
+}
+
+//
+// The uses of a symbol are spread over the body, so look the symbols up
+// in a scattered order rather than the order they were put.
+//
+static inline Node* useOf(int body, int use) {
+  int size = bodySizes[body];
+
+  return bodySymbols[body][((unsigned)use * 2654435761U) % (unsigned)size];
+}
+
+template <class M> static long runMap(M& map, int body) {
+  int  size  = bodySizes[body];
+  long found = 0;
+
+  for (int i = 0; i < size; i++)
+    map.put(bodySymbols[body][i], newSymbol);
+
+  for (int use = 0; use < size * kUsesPerSymbol; use++)
+    if (map.get(useOf(body, use)))
+      found++;
+
+  return found;
+}
+
+template <class M> static long iterateMap(M& map) {
+  long found = 0;
+
+  form_Map(NodeMapElem, e, map) {
+    if (e->value)
+      found++;
+  }
+
+  return found;
+}
+
+template <class M> static void bench(const char* name, int rounds) {
+  Timer timer;
+  long  found = 0;
+
+  timer.start();
+
+  for (int round = 0; round < rounds; round++) {
+    for (int body = 0; body < kNumBodies; body++) {
+      M map;
+
+      found += runMap(map, body);
+      found += iterateMap(map);
+    }
+  }
+
+  timer.stop();
+
+  printf("%-14s %8.3f seconds  (%ld hits)\n",
+         name, timer.elapsedSecs(), found);
+}
+
+//
+// ChainHashMap keeps its entries in lists, so it is walked with
+// get_values() rather than form_Map.
+//
+static void benchChainHashMap(int rounds) {
+  Timer timer;
+  long  found = 0;
+
+  timer.start();
+
+  for (int round = 0; round < rounds; round++) {
+    for (int body = 0; body < kNumBodies; body++) {
+      ChainHashMap<Node*, PtrHashFns, Node*> map;
+      Vec<Node*>                             values;
+
+      found += runMap(map, body);
+
+      map.get_values(values);
+      found += values.n;
+    }
+  }
+
+  timer.stop();
+
+  printf("%-14s %8.3f seconds  (%ld hits)\n",
+         "ChainHashMap", timer.elapsedSecs(), found);
+}
+
+// vec.o and timer.o report internal errors through misc.cpp
+void setupError(const char* filename, int lineno, int tag) {
+  fprintf(stderr, "%s:%d: internal error\n", filename, lineno);
+}
+
+void handleError(const char* fmt, ...) {
+  abort();
+}
+
+int main(int argc, char* argv[]) {
+  int rounds = (argc > 1) ? atoi(argv[1]) : 20;
+
+  buildWorkload();
+
+  bench<Map<Node*,Node*> >("Map", rounds);
+  bench<LegacyMap>("LegacyMap", rounds);
+  bench<HashMap<Node*, PtrHashFns, Node*> >("HashMap", rounds);
+  benchChainHashMap(rounds);
+
+  return 0;
+}
@@ -43,6 +43,8 @@ GenRet CForLoop::codegen()
 
   if (outfile)
   {
+    codegenAggregateBegin();
+
     BlockStmt*  initBlock = initBlockGet();
 
     // These copy calls are needed or else values get code generated twice.
@@ -79,6 +81,8 @@ GenRet CForLoop::codegen()
 
       info->cStatements.push_back(end);
     }
+
+    codegenAggregateEnd();
   }
 
   else
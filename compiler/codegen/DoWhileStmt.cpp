@@ -40,6 +40,8 @@ GenRet DoWhileStmt::codegen()
 
   if (outfile)
   {
+    codegenAggregateBegin();
+
     codegenOrderIndependence();
 
     info->cStatements.push_back("do ");
@@ -52,6 +54,8 @@ GenRet DoWhileStmt::codegen()
     std::string ftr= "} while (" + codegenValue(condExprGet()).c + ");\n";
 
     info->cStatements.push_back(ftr);
+
+    codegenAggregateEnd();
   }
 
   else
@@ -18,7 +18,28 @@
  */
 
 #include "LoopStmt.h"
+
+#include "astutil.h"
+#include "CForLoop.h"
 #include "codegen.h"
+#include "expr.h"
+#include "insertLineNumbers.h"
+#include "stlUtil.h"
+#include "stringutil.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+// The symbols assigned in a loop body, each mapped to the value it is
+// assigned or to NULL if it is assigned anything but a single copy.
+typedef std::map<Symbol*, Expr*> BodyDefs;
+
+static const char* vectorizationObstacle(LoopStmt* loop);
+static const char* inductionObstacle(CForLoop* loop, BodyDefs& bodyDefs);
+static const char* bodyObstacle(LoopStmt* loop, BodyDefs& bodyDefs);
+static bool        isWideSymbol(Symbol* sym);
+static bool        isHoisted(Symbol* base, BodyDefs& bodyDefs);
 
 // If vectorization is enabled and this loop is order independent, codegen
 // CHPL_PRAGMA_IVDEP. This method is a no-op if vectorization is off, or the
@@ -38,11 +59,249 @@ void LoopStmt::codegenOrderIndependence()
 
       if (developer || mod->modTag == MOD_USER)
       {
-        printf("Adding %s to %s for %s:%d\n", ivdepStr.c_str(),
-            this->astTagAsString(), mod->name, this->linenum());
+        const char* obstacle = vectorizationObstacle(this);
+
+        if (obstacle == NULL)
+          printf("Adding %s to %s for %s:%d (vectorization ready)\n",
+              ivdepStr.c_str(), this->astTagAsString(), mod->name,
+              this->linenum());
+        else
+          printf("Adding %s to %s for %s:%d (not vectorization ready: %s)\n",
+              ivdepStr.c_str(), this->astTagAsString(), mod->name,
+              this->linenum(), obstacle);
       }
     }
 
     info->cStatements.push_back(ivdepStr+'\n');
   }
 }
+
+// If this loop aggregates its remote PUTs, open a block that declares the
+// aggregator.  The remote PUTs in the loop are generated to use it.
+void LoopStmt::codegenAggregateBegin()
+{
+  if (aggregatesRemoteOps())
+  {
+    GenInfo* info = gGenInfo;
+
+    info->cStatements.push_back("{\n");
+    info->cStatements.push_back("chpl_comm_aggregator_t chpl_aggregator;\n");
+    info->cStatements.push_back("chpl_comm_aggregate_init(&chpl_aggregator);\n");
+
+    info->inAggregatedLoop = true;
+  }
+}
+
+// Send the PUTs that are still buffered and close the aggregator's block.
+void LoopStmt::codegenAggregateEnd()
+{
+  if (aggregatesRemoteOps())
+  {
+    GenInfo*    info  = gGenInfo;
+    char        buf[32];
+    std::string flush = "chpl_comm_aggregate_flush(&chpl_aggregator, ";
+
+    info->inAggregatedLoop = false;
+
+    snprintf(buf, sizeof(buf), "%d, %d", linenum(),
+             gFilenameLookupCache[fname()]);
+
+    flush += buf;
+    flush += ");\n";
+
+    info->cStatements.push_back(flush);
+    info->cStatements.push_back("}\n");
+  }
+}
+
+/************************************ | *************************************
+*                                                                           *
+* Vectorization readiness, reported by --report-order-independent-loops.    *
+*                                                                           *
+* The backend compilers vectorize an order independent loop if it has a     *
+* unit-stride induction variable and a bound the loop does not change, and  *
+* its body is straight-line code that indexes local memory through base     *
+* pointers that are not reloaded on each iteration.  LICM hoists the base  *
+* pointer loads of an inlined DefaultRectangular follower out of the loop;  *
+* a class field load left in the loop means it could not.                   *
+*                                                                           *
+************************************* | ************************************/
+
+// Returns NULL if the loop is ready, or else the first reason it is not.
+static const char* vectorizationObstacle(LoopStmt* loop)
+{
+  CForLoop*   cforLoop = toCForLoop(loop);
+  BodyDefs    bodyDefs;
+  const char* retval   = NULL;
+
+  if (cforLoop == NULL)
+    return "no induction variable";
+
+  for_alist(stmt, loop->body)
+  {
+    std::vector<SymExpr*> symExprs;
+
+    collectSymExprs(stmt, symExprs);
+
+    for_vector(SymExpr, se, symExprs)
+    {
+      if (CallExpr* call = toCallExpr(se->parentExpr))
+      {
+        if ((call->isPrimitive(PRIM_MOVE)   ||
+             call->isPrimitive(PRIM_ASSIGN) ||
+             call->isPrimitive(PRIM_ADD_ASSIGN)) && call->get(1) == se)
+        {
+          bool copy = call->isPrimitive(PRIM_ADD_ASSIGN) == false &&
+                      bodyDefs.count(se->symbol())             == 0;
+
+          bodyDefs[se->symbol()] = copy ? call->get(2) : NULL;
+        }
+      }
+    }
+  }
+
+  retval = inductionObstacle(cforLoop, bodyDefs);
+
+  if (retval == NULL)
+    retval = bodyObstacle(loop, bodyDefs);
+
+  return retval;
+}
+
+// The incr block may only add 1 to the induction variables, which the body
+// and the test must leave alone.
+static const char* inductionObstacle(CForLoop* loop, BodyDefs& bodyDefs)
+{
+  std::vector<CallExpr*> calls;
+  std::set<Symbol*>      indices;
+
+  collectCallExprs(loop->incrBlockGet(), calls);
+
+  for_vector(CallExpr, call, calls)
+  {
+    if (call->isPrimitive(PRIM_ADD_ASSIGN) || call->isPrimitive(PRIM_ADD))
+    {
+      VarSymbol* incr = toVarSymbol(toSymExpr(call->get(2)) ?
+                                    toSymExpr(call->get(2))->symbol() : NULL);
+
+      if (incr                        == NULL           ||
+          incr->immediate             == NULL           ||
+          (incr->immediate->const_kind != NUM_KIND_INT  &&
+           incr->immediate->const_kind != NUM_KIND_UINT) ||
+          incr->immediate->to_int()   != 1)
+        return "non-unit stride";
+
+    }
+    else if (!call->isPrimitive(PRIM_MOVE) && !call->isPrimitive(PRIM_ASSIGN))
+    {
+      return "non-unit stride";
+    }
+
+    if (call->isPrimitive(PRIM_ADD) == false)
+      indices.insert(toSymExpr(call->get(1))->symbol());
+  }
+
+  if (indices.empty())
+    return "no induction variable";
+
+  for_set(Symbol, index, indices)
+  {
+    if (bodyDefs.count(index) != 0)
+      return "induction variable assigned in the loop";
+  }
+
+  std::vector<SymExpr*> symExprs;
+
+  collectSymExprs(loop->testBlockGet(), symExprs);
+
+  for_vector(SymExpr, se, symExprs)
+  {
+    if (indices.count(se->symbol()) == 0 && bodyDefs.count(se->symbol()) != 0)
+      return "loop bound assigned in the loop";
+  }
+
+  return NULL;
+}
+
+static const char* bodyObstacle(LoopStmt* loop, BodyDefs& bodyDefs)
+{
+  std::vector<BaseAST*> asts;
+
+  for_alist(stmt, loop->body)
+    collect_asts(stmt, asts);
+
+  for_vector(BaseAST, ast, asts)
+  {
+    if (isLoopStmt(ast))
+      return "contains a loop";
+
+    if (GotoStmt* gotoStmt = toGotoStmt(ast))
+    {
+      LabelSymbol* target = gotoStmt->gotoTarget();
+
+      if (target == NULL || target->defPoint->parentExpr != loop)
+        return "leaves the loop early";
+    }
+
+    if (SymExpr* se = toSymExpr(ast))
+    {
+      if (isWideSymbol(se->symbol()))
+        return "accesses wide references";
+    }
+
+    if (CallExpr* call = toCallExpr(ast))
+    {
+      if (FnSymbol* fn = call->isResolved())
+      {
+        if (fn->hasFlag(FLAG_EXTERN) == false)
+          return astr("calls ", fn->name);
+      }
+      else if (call->isPrimitive(PRIM_RETURN))
+      {
+        return "leaves the loop early";
+      }
+      else if (call->isPrimitive(PRIM_GET_MEMBER)       ||
+               call->isPrimitive(PRIM_GET_MEMBER_VALUE))
+      {
+        if (isClass(call->get(1)->typeInfo()))
+          return "loads a class field";
+      }
+      else if (call->isPrimitive(PRIM_ARRAY_GET)       ||
+               call->isPrimitive(PRIM_ARRAY_GET_VALUE) ||
+               call->isPrimitive(PRIM_ARRAY_SET)       ||
+               call->isPrimitive(PRIM_ARRAY_SET_FIRST))
+      {
+        SymExpr* base = toSymExpr(call->get(1));
+
+        if (base == NULL || isHoisted(base->symbol(), bodyDefs) == false)
+          return "array base pointer not hoisted";
+      }
+    }
+  }
+
+  return NULL;
+}
+
+static bool isWideSymbol(Symbol* sym)
+{
+  TypeSymbol* ts = sym->type->symbol;
+
+  return ts->hasFlag(FLAG_WIDE_REF) || ts->hasFlag(FLAG_WIDE_CLASS);
+}
+
+// A base pointer the body assigns is hoisted if it is just a copy of one
+// that is not assigned in the body.
+static bool isHoisted(Symbol* base, BodyDefs& bodyDefs)
+{
+  BodyDefs::iterator it     = bodyDefs.find(base);
+  bool               retval = true;
+
+  if (it != bodyDefs.end())
+  {
+    SymExpr* rhs = toSymExpr(it->second);
+
+    retval = rhs != NULL && bodyDefs.count(rhs->symbol()) == 0;
+  }
+
+  return retval;
+}
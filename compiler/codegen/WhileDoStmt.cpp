@@ -40,6 +40,7 @@ GenRet WhileDoStmt::codegen()
 
   if (outfile)
   {
+    codegenAggregateBegin();
 
     codegenOrderIndependence();
 
@@ -62,6 +63,8 @@ GenRet WhileDoStmt::codegen()
 
       info->cStatements.push_back(end);
     }
+
+    codegenAggregateEnd();
   }
 
   else
@@ -24,12 +24,14 @@
 #include "codegen.h"
 
 #include "astutil.h"
+#include "compilerTrace.h"
 #include "stlUtil.h"
 #include "config.h"
 #include "driver.h"
 #include "expr.h"
 #include "files.h"
 #include "mysystem.h"
+#include "optimizations.h"
 #include "passes.h"
 #include "stmt.h"
 #include "stringutil.h"
@@ -46,6 +48,8 @@
 #include <cstdio>
 #include <vector>
 
+#include <unistd.h>
+
 // Global so that we don't have to pass around
 // to all of the codegen() routines
 GenInfo* gGenInfo   =  0;
@@ -754,6 +758,7 @@ static void codegen_header_compilation_config() {
 
     genGlobalInt("CHPL_STACK_CHECKS", !fNoStackChecks, false);
     genGlobalInt("CHPL_CACHE_REMOTE", fCacheRemote, false);
+    genGlobalInt("CHPL_AGGREGATE_REMOTE_OPS", fAggregateRemoteOps, false);
 
     for (std::map<std::string, const char*>::iterator env=envMap.begin(); env!=envMap.end(); ++env) {
       if (env->first != "CHPL_HOME") {
@@ -883,6 +888,7 @@ static void protectNameFromC(Symbol* sym) {
 // TODO: Split this into a number of smaller routines.<hilde>
 static void codegen_defn(std::set<const char*> & cnames, std::vector<TypeSymbol*> & types,
   std::vector<FnSymbol*> & functions, std::vector<VarSymbol*> & globals) {
+  TraceRegion region("codegen_defn");
   GenInfo* info = gGenInfo;
   FILE* hdrfile = info->cfile;
 
@@ -960,6 +966,7 @@ static void codegen_defn(std::set<const char*> & cnames, std::vector<TypeSymbol*
 
 static void codegen_header(std::set<const char*> & cnames, std::vector<TypeSymbol*> & types,
   std::vector<FnSymbol*> & functions, std::vector<VarSymbol*> & globals) {
+  TraceRegion region("codegen_header");
   GenInfo* info = gGenInfo;
 
   // reserved symbol names that require renaming to compile
@@ -1389,6 +1396,7 @@ static void codegen_header_addons() {
 
 static void
 codegen_config() {
+  TraceRegion region("codegen_config");
   GenInfo* info = gGenInfo;
 
   // LLVM backend need _config.c generated for the launcher,
@@ -1538,6 +1546,91 @@ static const char* generateFileName(ChainHashMap<char*, StringHashFns, int>& fil
   return name;
 }
 
+/************************************* | **************************************
+*                                                                             *
+* With --incremental, the modules are compiled as several translation units   *
+* rather than being included into _main.c.  Each module is assigned to the    *
+* unit with the least generated code so far, largest module first, so that    *
+* the units take about the same time to compile.  The generated Makefile      *
+* builds the units in parallel.                                               *
+*                                                                             *
+************************************** | *************************************/
+
+struct ModuleCode {
+  const char* filename;
+  long        size;       // bytes of generated C
+};
+
+static bool largerModuleCode(const std::pair<long, int>& a,
+                             const std::pair<long, int>& b) {
+  return (a.first != b.first) ? a.first > b.first : a.second < b.second;
+}
+
+static int numCodegenPartitions() {
+  long numCores = sysconf(_SC_NPROCESSORS_ONLN);
+
+  if (fIncrementalPartitions > 0)
+    return fIncrementalPartitions;
+
+  return (numCores > 1) ? (int) numCores : 1;
+}
+
+//
+// Write the translation units; returns their paths without the .c
+// suffix, as expected by CHPLUSEROBJ in the generated Makefile
+//
+static std::vector<const char*>
+codegenPartitions(const std::vector<ModuleCode>& modules) {
+  std::vector<const char*>          retval;
+  int                               numParts = numCodegenPartitions();
+  std::vector<std::pair<long, int> > bySize;
+  std::vector<int>                  partOf(modules.size(), 0);
+
+  if ((int) modules.size() < numParts)
+    numParts = (int) modules.size();
+
+  for (size_t i = 0; i < modules.size(); i++)
+    bySize.push_back(std::make_pair(modules[i].size, (int) i));
+
+  std::sort(bySize.begin(), bySize.end(), largerModuleCode);
+
+  std::vector<long> partSize(numParts, 0);
+
+  for (size_t i = 0; i < bySize.size(); i++) {
+    int smallest = 0;
+
+    for (int part = 1; part < numParts; part++) {
+      if (partSize[part] < partSize[smallest])
+        smallest = part;
+    }
+
+    partOf[bySize[i].second]  = smallest;
+    partSize[smallest]       += bySize[i].first;
+  }
+
+  for (int part = 0; part < numParts; part++) {
+    fileinfo partfile;
+
+    openCFile(&partfile, astr("chpl__partition", istr(part + 1)), "c");
+
+    fprintf(partfile.fptr, "#include \"chpl__header.h\"\n");
+
+    // keep the modules in their original order within each unit
+    for (size_t i = 0; i < modules.size(); i++) {
+      if (partOf[i] == part)
+        fprintf(partfile.fptr, "#include \"%s\"\n", modules[i].filename);
+    }
+
+    closeCFile(&partfile, false);
+
+    std::string path(partfile.pathname);
+
+    retval.push_back(astr(path.substr(0, path.length() - 2).c_str()));
+  }
+
+  return retval;
+}
+
 
 static bool
 shouldChangeArgumentTypeToRef(ArgSymbol* arg) {
@@ -1633,6 +1726,9 @@ void codegen(void) {
 
   INT_ASSERT(info);
 
+  if (fAggregateRemoteOps == true && fLocal == false && llvmCodegen == false)
+    markAggregatedLoops();
+
   adjustArgSymbolTypesForIntent();
 
   forv_Vec(VarSymbol, sym, gVarSymbols) {
@@ -1717,26 +1813,6 @@ void codegen(void) {
     fprintf(mainfile.fptr, "#include \"%s.c\"\n", sCfgFname);
     fprintf(mainfile.fptr, "#include \"chpl__defn.c\"\n");
 
-    std::vector<const char*> userFileName;
-    if(fIncrementalCompilation) {
-      ChainHashMap<char*, StringHashFns, int> fileNameHashMap;
-      forv_Vec(ModuleSymbol, currentModule, allModules) {
-        const char* filename = NULL;
-        filename = generateFileName(fileNameHashMap, filename, currentModule->name);
-        if(currentModule->modTag == MOD_USER) {
-          fileinfo modulefile;
-          openCFile(&modulefile, filename, "c");
-          int modulePathLen = strlen(astr(modulefile.pathname));
-          char path[FILENAME_MAX];
-          strncpy(path, astr(modulefile.pathname), modulePathLen-2);
-          path[modulePathLen-2]='\0';
-          userFileName.push_back(astr(path));
-          closeCFile(&modulefile);
-        }
-      }
-    }
-
-    codegen_makefile(&mainfile, NULL, false, userFileName);
   }
 
   // Vectors to store different symbol names to be used while generating header
@@ -1760,6 +1836,8 @@ void codegen(void) {
   if( llvmCodegen ) {
 #ifdef HAVE_LLVM
     forv_Vec(ModuleSymbol, currentModule, allModules) {
+      TraceRegion region("codegenModule", currentModule->name);
+
       mysystem(astr("# codegen-ing module", currentModule->name),
                "generating comment for --print-commands option");
       currentModule->codegenDef();
@@ -1780,7 +1858,11 @@ void codegen(void) {
     }
 
     ChainHashMap<char*, StringHashFns, int> fileNameHashMap;
+    std::vector<ModuleCode>                 moduleCode;
+
     forv_Vec(ModuleSymbol, currentModule, allModules) {
+      TraceRegion region("codegenModule", currentModule->name);
+
       mysystem(astr("# codegen-ing module", currentModule->name),
                "generating comment for --print-commands option");
 
@@ -1790,15 +1872,27 @@ void codegen(void) {
       fileinfo modulefile;
       openCFile(&modulefile, filename, "c");
       info->cfile = modulefile.fptr;
-      if(fIncrementalCompilation && (currentModule->modTag == MOD_USER))
-        fprintf(modulefile.fptr, "#include \"chpl__header.h\"\n");
       currentModule->codegenDef();
-      closeCFile(&modulefile);
 
-      if(!(fIncrementalCompilation && (currentModule->modTag == MOD_USER)))
+      if (fIncrementalCompilation) {
+        ModuleCode code;
+
+        code.filename = modulefile.filename;
+        code.size     = ftell(modulefile.fptr);
+
+        moduleCode.push_back(code);
+      } else {
         fprintf(mainfile.fptr, "#include \"%s%s\"\n", filename, ".c");
+      }
+
+      closeCFile(&modulefile);
     }
 
+    if (fIncrementalCompilation)
+      codegen_makefile(&mainfile, NULL, false, codegenPartitions(moduleCode));
+    else
+      codegen_makefile(&mainfile);
+
     fprintf(strconfig.fptr, "#include \"chpl-string.h\"\n");
     fprintf(strconfig.fptr, "chpl_string defaultStringValue=\"\";\n");
 
@@ -1830,7 +1924,14 @@ void makeBinary(void) {
 #endif
   } else {
     const char* makeflags = printSystemCommands ? "-f " : "-s -f ";
+    const char* jobs      = "";
+
+    // build the translation units from --incremental in parallel
+    if (fIncrementalCompilation)
+      jobs = astr("-j", istr(numCodegenPartitions()), " ");
+
     const char* command = astr(astr(CHPL_MAKE, " "),
+                               jobs,
                                makeflags,
                                getIntermediateDirName(), "/Makefile");
     mysystem(command, "compiling generated source");
@@ -1848,6 +1949,7 @@ GenInfo::GenInfo(
     bool parseOnlyIn )
        :   cfile(NULL), cLocalDecls(), cStatements(),
            lineno(-1), filename(NULL), parseOnly(parseOnlyIn),
+           inAggregatedLoop(false),
            // the rest of these are only in GenInfo with HAVE_LLVM
            module(NULL), builder(NULL), lvt(NULL),
            clangCC(clangCcIn),
@@ -1890,7 +1992,8 @@ GenInfo::GenInfo(
 // No LLVM
 GenInfo::GenInfo()
          :   cfile(NULL), cLocalDecls(), cStatements(),
-             lineno(-1), filename(NULL), parseOnly(false)
+             lineno(-1), filename(NULL), parseOnly(false),
+             inAggregatedLoop(false)
 #ifdef HAVE_LLVM
              // Could set more of these to NULL, but the real
              // point is to just core-dump if we end up trying
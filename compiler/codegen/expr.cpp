@@ -2389,7 +2389,6 @@ void codegenCall(const char* fnName, GenRet a1, GenRet a2, GenRet a3,
   codegenCall(fnName, args);
 }
 
-/* Commented out to avoid an unused function, this probably should be varargs
 static
 void codegenCall(const char* fnName, GenRet a1, GenRet a2, GenRet a3,
                  GenRet a4, GenRet a5, GenRet a6, GenRet a7, GenRet a8)
@@ -2406,6 +2405,7 @@ void codegenCall(const char* fnName, GenRet a1, GenRet a2, GenRet a3,
   codegenCall(fnName, args);
 }
 
+/* Commented out to avoid an unused function, this probably should be varargs
 static
 void codegenCall(const char* fnName, GenRet a1, GenRet a2, GenRet a3,
                  GenRet a4, GenRet a5, GenRet a6, GenRet a7, GenRet a8,
@@ -2820,6 +2820,17 @@ GenRet codegenCastPtrToInt(Type* toType, GenRet value)
 }
 */
 
+// The aggregator declared around a loop by LoopStmt::codegenAggregateBegin()
+static
+GenRet aggregatorAddr()
+{
+  GenRet ret;
+
+  ret.c = "&chpl_aggregator";
+
+  return ret;
+}
+
 // Generates code to perform an "assignment" operation, given
 //  a destination pointer and a value.
 // That's basically
@@ -2978,6 +2989,15 @@ void codegenAssign(GenRet to_ptr, GenRet from)
           // We already know to is a pointer (wide or not).
           // Make sure that from is a pointer
           codegenCopy(to_ptr, from, type);
+        } else if (info->inAggregatedLoop) {
+          codegenCall("chpl_gen_comm_put_aggregate",
+                      aggregatorAddr(),
+                      codegenCastToVoidStar(codegenValuePtr(from)),
+                      codegenRnode(to_ptr),
+                      codegenRaddr(to_ptr),
+                      codegenSizeof(type),
+                      genTypeStructureIndex(type->symbol),
+                      info->lineno, gFilenameLookupCache[info->filename]);
         } else {
           codegenCall("chpl_gen_comm_put",
                       codegenCastToVoidStar(codegenValuePtr(from)),
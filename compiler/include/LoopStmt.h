@@ -36,6 +36,10 @@ public:
   bool                   isOrderIndependent()                         const;
   void                   orderIndependentSet(bool b);
 
+  // Set just before code generation; see aggregateRemoteOps.cpp
+  bool                   aggregatesRemoteOps()                        const;
+  void                   aggregateRemoteOpsSet(bool b);
+
   static LoopStmt*       findEnclosingLoop(Expr* expr);
 
 protected:
@@ -45,7 +49,10 @@ protected:
   LabelSymbol*           mBreakLabel;
   LabelSymbol*           mContinueLabel;
   bool                   mOrderIndependent;
+  bool                   mAggregateRemoteOps;
   void                   codegenOrderIndependence();
+  void                   codegenAggregateBegin();
+  void                   codegenAggregateEnd();
 
 
 private:
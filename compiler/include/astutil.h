@@ -183,6 +183,10 @@ bool isTypeExpr(Expr* expr);
 Symbol* getSvecSymbol(CallExpr* call);
 void collectUsedFnSymbols(BaseAST* ast, std::set<FnSymbol*>& fnSymbols);
 
+// collect the class fields that are only written while an instance is
+// being constructed; their values never change once an instance is in use
+void collectWriteOnceFields(std::set<Symbol*>& writeOnceFields);
+
 // move to resolve when scope resolution is put in resolution directory
 BlockStmt* getVisibilityBlock(Expr* expr);
 
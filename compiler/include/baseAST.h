@@ -180,6 +180,10 @@ static inline bool isType(AstTag tag)
 // The outermost call to copy invokes the copyInner method used to
 // implement the recursive copy.
 //
+// If the copy defined no symbols and the caller supplied no
+// substitutions, the map is empty and update_symbols would not change
+// anything, so the walk over the new subtree is skipped.
+//
 #define DECLARE_COPY(type)                                              \
   type* copy(SymbolMap* map = NULL, bool internal = false) {            \
     SymbolMap localMap;                                                 \
@@ -187,7 +191,7 @@ static inline bool isType(AstTag tag)
       map = &localMap;                                                  \
     type* _this = copyInner(map);                                       \
     _this->astloc = astloc;                                             \
-    if (!internal)                                                      \
+    if (!internal && map->n != 0)                                       \
       update_symbols(_this, map);                                       \
     return _this;                                                       \
   }                                                                     \
@@ -250,6 +254,9 @@ public:
 
   static  const       std::string tabText;
 
+  static void*        operator new(size_t size);
+  static void         operator delete(void* ptr, size_t size);
+
 protected:
                     BaseAST(AstTag type);
   virtual          ~BaseAST();
@@ -589,6 +596,17 @@ void destroyAst(void);
 //
 void printStatistics(const char* pass);
 
+//
+// print the memory held by AST nodes during and after a pass (called
+// after each pass if using --print-ast-memory)
+//
+void printAstMemory(const char* pass);
+
+//
+// the number of bytes currently held by live AST nodes
+//
+size_t astMemoryInUse();
+
 void registerModule(ModuleSymbol* mod);
 
 //
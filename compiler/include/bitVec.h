@@ -21,10 +21,11 @@
 #define _CHPL_BIT_VEC_H_
 
 #include <cstddef>
+#include <stdint.h>
 
 class BitVec {
 public:
-  unsigned* data;
+  uint64_t* data;                  // 64 bits per word
   size_t    in_size;
   size_t    ndata;
 
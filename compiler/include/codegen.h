@@ -72,6 +72,11 @@ struct GenInfo {
   const char* filename;
 
   bool parseOnly;
+
+  // Is the C code for a loop whose remote PUTs are aggregated being
+  // generated?  See aggregateRemoteOps.cpp.
+  bool inAggregatedLoop;
+
 #ifdef HAVE_LLVM
   // If we're generating LLVM, the following are available
   llvm::Module *module;
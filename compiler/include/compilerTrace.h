@@ -0,0 +1,92 @@
+/*
+ * Copyright 2004-2016 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _COMPILER_TRACE_H_
+#define _COMPILER_TRACE_H_
+
+class Timer;
+
+/************************************* | **************************************
+*                                                                             *
+* The PhaseTracker accounts for the time spent in each pass.  The classes in  *
+* this file provide a finer grained view of the time spent within a pass.     *
+*                                                                             *
+* A TraceRegion records the time between its construction and destruction,   *
+* along with the change in the memory held by AST nodes over that interval.   *
+* Regions may nest, e.g.                                                      *
+*                                                                             *
+*    FnSymbol* resolveNormalCall(CallExpr* call, bool checkonly) {            *
+*      TraceRegion region("resolveNormalCall", ...);                          *
+*      ...                                                                    *
+*    }                                                                        *
+*                                                                             *
+* A TraceCounter is a named running total.  Counters are sampled at the       *
+* start of every phase.                                                       *
+*                                                                             *
+* Regions are only recorded when --compiler-trace=<file> is given; the        *
+* compiler then writes the passes, the regions and the counters to <file>     *
+* in the Chrome trace event format (chrome://tracing, Perfetto, etc.).        *
+*                                                                             *
+************************************** | *************************************/
+
+class TraceRegion
+{
+public:
+  // detail must outlive the trace e.g. a symbol name or an astr() string
+                       TraceRegion(const char* name,
+                                   const char* detail = 0);
+                      ~TraceRegion();
+
+private:
+                       TraceRegion();
+
+  int                  mIndex;          // -1 if tracing is not enabled
+};
+
+class TraceCounter
+{
+public:
+                       TraceCounter(const char* name);
+
+  void                 Add(long delta = 1)      { mValue = mValue + delta; }
+
+  const char*          mName;
+  long                 mValue;
+  TraceCounter*        mNext;
+
+private:
+                       TraceCounter();
+};
+
+bool                   traceEnabled();
+
+// Regions are timed against the PhaseTracker's timer
+void                   traceSetClock(const Timer* clock);
+
+void                   traceAddPhase(const char*   name,
+                                     const char*   category,
+                                     unsigned long startTime,
+                                     unsigned long endTime,
+                                     long          astBytes);
+
+void                   traceSampleCounters();
+
+void                   traceWrite(const char* filename);
+
+#endif
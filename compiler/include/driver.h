@@ -38,9 +38,12 @@ extern bool fNoBoundsChecks;
 extern bool fNoCopyPropagation;
 extern bool fNoDeadCodeElimination;
 extern bool fNoGlobalConstOpt;
+extern bool fNoHeapVarEscapeAnalysis;
 extern bool fNoFastFollowers;
 extern bool fNoInlineIterators;
 extern bool fNoloopInvariantCodeMotion;
+extern bool fLoopInvariantRemoteHoist;
+extern bool fWideArgClones;
 extern bool fNoInline;
 extern bool fNoLiveAnalysis;
 extern bool fNoFormalDomainChecks;
@@ -52,6 +55,7 @@ extern bool fMungeUserIdents;
 extern bool fEnableTaskTracking;
 extern bool fLLVMWideOpt;
 
+extern bool fAggregateRemoteOps;
 extern bool fNoRemoteValueForwarding;
 extern bool fNoRemoveCopyCalls;
 extern bool fNoScalarReplacement;
@@ -62,10 +66,12 @@ extern bool fNoVectorize;
 extern bool fNoPrivatization;
 extern bool fNoOptimizeOnClauses;
 extern bool fNoRemoveEmptyRecords;
+extern bool fNoMemoizeResolution;
 extern bool fRemoveUnreachableBlocks;
 extern bool fReplaceArrayAccessesWithRefTemps;
 extern int  optimize_on_clause_limit;
 extern int  scalar_replace_limit;
+extern int  inline_size_budget;
 extern int  tuple_copy_limit;
 
 
@@ -126,6 +132,8 @@ extern bool fPrintIDonError;
 extern bool fPrintModuleResolution;
 extern bool fPrintEmittedCodeSize;
 extern char fPrintStatistics[256];
+extern bool fPrintAstMemory;
+extern char fCompilerTrace[FILENAME_MAX+1];
 extern bool fPrintDispatch;
 extern bool fGenIDS;
 extern bool fLocal;
@@ -174,9 +182,11 @@ extern bool fReportOptimizedLoopIterators;
 extern bool fReportOrderIndependentLoops;
 extern bool fReportOptimizedOn;
 extern bool fReportPromotion;
+extern bool fReportRemoteValueForwarding;
 extern bool fReportScalarReplace;
 extern bool fReportDeadBlocks;
 extern bool fReportDeadModules;
+extern bool fReportVisibilityStats;
 
 extern bool debugCCode;
 extern bool optimizeCCode;
@@ -200,6 +210,10 @@ extern bool fMinimalModules;
 // Set to true if we want to enable incremental compilation.
 extern bool fIncrementalCompilation;
 
+// The number of translation units for incremental compilation;
+// 0 means one per online processor.
+extern int  fIncrementalPartitions;
+
 // Set to true if we want to use the experimental
 // Interactive Programming Environment (IPE) mode.
 extern bool fUseIPE;
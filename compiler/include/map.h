@@ -53,6 +53,7 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <cstdlib>
 #include <cstring>
 #include <cassert>
+#include <stdint.h>
 #include "vec.h"
 #include "list.h"
 
@@ -67,7 +68,17 @@ _dupstr(char *s, char *e = 0) {
 
 // Simple direct mapped Map (pointer hash table) and Environment
 // The key ((K)0) has a special meaning and so should not be used.
-// The removal operation is not provided.
+//
+// A Map of up to SET_LINEAR_SIZE elements keeps them in insertion order
+// in v[0..n).  A larger Map is an open-addressing table: v holds n slots,
+// n is a power of two, and a key lives in the first free slot at or after
+// the one picked by a multiplicative hash of the key (linear probing).  i
+// counts the keys in the table, which is grown to keep it at most three
+// quarters full.  Removal shifts the following entries back, so there are no
+// tombstones and lookups stop at the first empty slot.
+//
+// form_Map iterates over v[0..n) skipping empty slots and works for both
+// representations.
 
 template <class K, class C> class MapElem {
  public:
@@ -90,11 +101,20 @@ template <class K, class C> class Map : public Vec<MapElem<K,C> > {
   using Vec<MapElem<K, C> >::v;
   MapElem<K,C> *put(K akey, C avalue);
   C get(K akey);
+  int del(K akey);
   void get_keys(Vec<K> &keys);
   void get_keys_set(Vec<K> &keys);
   void get_values(Vec<C> &values);
   MapElem<K,C> *get_record(K akey);
   void map_union(Map<K,C> &m);
+ private:
+  // the Vec set operations use a different layout
+  using Vec<MapElem<K, C> >::set_add;
+  using Vec<MapElem<K, C> >::set_in;
+  using Vec<MapElem<K, C> >::set_union;
+  int slot(K akey);
+  MapElem<K,C> *put_internal(K akey, C avalue);
+  void grow();
 };
 
 template <class C> class HashFns {
@@ -209,24 +229,100 @@ extern unsigned int open_hash_multipliers[256];
 
 /* IMPLEMENTATION */
 
+#define MAP_INITIAL_SIZE        8               /* must be a power of 2 */
+
+template <class K, class C> inline int
+Map<K,C>::slot(K akey) {
+  // Fibonacci hashing: the high bits of the product are well mixed even
+  // for aligned pointers
+  uint64_t h = (uint64_t)(uintptr_t)akey * 0x9E3779B97F4A7C15ULL;
+  return (int)(h >> 32) & (n - 1);
+}
+
+template <class K, class C> inline MapElem<K,C> *
+Map<K,C>::get_record(K akey) {
+  if (n <= SET_LINEAR_SIZE) {
+    for (MapElem<K,C> *c = v; c < v + n; c++)
+      if (c->key == akey)
+        return c;
+    return 0;
+  }
+  for (int k = slot(akey); v[k].key; k = (k + 1) & (n - 1))
+    if (v[k].key == akey)
+      return &v[k];
+  return 0;
+}
+
 template <class K, class C> inline C 
 Map<K,C>::get(K akey) {
-  MapElem<K,C> e(akey, (C)0);
-  MapElem<K,C> *x = this->set_in(e);
+  MapElem<K,C> *x = get_record(akey);
   if (x)
     return x->value;
   return (C)0;
 }
 
+template <class K, class C> inline MapElem<K,C> *
+Map<K,C>::put_internal(K akey, C avalue) {
+  int k = slot(akey);
+  while (v[k].key)
+    k = (k + 1) & (n - 1);
+  v[k].key = akey;
+  v[k].value = avalue;
+  i++;
+  return &v[k];
+}
+
+template <class K, class C> void
+Map<K,C>::grow() {
+  Vec<MapElem<K,C> > vv;
+  vv.move(*this);
+  n = (vv.n <= SET_LINEAR_SIZE) ? MAP_INITIAL_SIZE : vv.n * 2;
+  i = 0;
+  v = (MapElem<K,C>*)malloc(n * sizeof(MapElem<K,C>));
+  memset(v, 0, n * sizeof(MapElem<K,C>));
+  for (int j = 0; j < vv.n; j++)
+    if (vv.v[j].key)
+      put_internal(vv.v[j].key, vv.v[j].value);
+}
+
 template <class K, class C> inline MapElem<K,C> *
 Map<K,C>::put(K akey, C avalue) {
-  MapElem<K,C> e(akey, avalue);
-  MapElem<K,C> *x = this->set_in(e);
+  MapElem<K,C> *x = get_record(akey);
   if (x) {
     x->value = avalue;
     return x;
-  } else
-    return this->set_add(e);
+  }
+  if (n < SET_LINEAR_SIZE) {
+    MapElem<K,C> e(akey, avalue);
+    this->add(e);
+    return &v[n-1];
+  }
+  if (n == SET_LINEAR_SIZE || 4 * (i + 1) > 3 * n)
+    grow();
+  return put_internal(akey, avalue);
+}
+
+template <class K, class C> int
+Map<K,C>::del(K akey) {
+  MapElem<K,C> *x = get_record(akey);
+  if (!x)
+    return 0;
+  if (n <= SET_LINEAR_SIZE) {
+    this->remove(x - v);
+    return 1;
+  }
+  int hole = x - v;
+  for (int k = (hole + 1) & (n - 1); v[k].key; k = (k + 1) & (n - 1)) {
+    // move v[k] into the hole unless its home slot lies after the hole
+    int home = slot(v[k].key);
+    if (((k - home) & (n - 1)) >= ((k - hole) & (n - 1))) {
+      v[hole] = v[k];
+      hole = k;
+    }
+  }
+  memset(&v[hole], 0, sizeof(MapElem<K,C>));
+  i--;
+  return 1;
 }
 
 template <class K, class C> inline void
@@ -251,12 +347,6 @@ Map<K,C>::get_values(Vec<C> &values) {
   values.set_to_vec();
 }
 
-template <class K, class C> inline MapElem<K,C> *
-Map<K,C>::get_record(K akey) {
-  MapElem<K,C> e(akey, (C)0);
-  MapElem<K,C> *x = this->set_in(e);
-  return x;
-}
 
 template <class K, class C> inline void
 Map<K,C>::map_union(Map<K,C> &m) {
@@ -363,8 +453,7 @@ template <class C, class AHashFns> C
 ChainHash<C, AHashFns>::put(C c) {
   unsigned int h = AHashFns::hash(c);
   List<C> *l;
-  MapElem<unsigned int,List<C> > e(h, (C)0);
-  MapElem<unsigned int,List<C> > *x = this->set_in(e);
+  MapElem<unsigned int,List<C> > *x = this->get_record(h);
   if (x)
     l = &x->value;
   else {
@@ -381,9 +470,7 @@ ChainHash<C, AHashFns>::put(C c) {
 template <class C, class AHashFns> C
 ChainHash<C, AHashFns>::get(C c) {
   unsigned int h = AHashFns::hash(c);
-  List<C> empty;
-  MapElem<unsigned int,List<C> > e(h, empty);
-  MapElem<unsigned int,List<C> > *x = this->set_in(e);
+  MapElem<unsigned int,List<C> > *x = this->get_record(h);
   if (!x)
     return 0;
   List<C> *l = &x->value;
@@ -406,8 +493,7 @@ template <class C, class AHashFns> int
 ChainHash<C, AHashFns>::del(C c) {
   unsigned int h = AHashFns::hash(c);
   List<C> *l;
-  MapElem<unsigned int,List<C> > e(h, (C)0);
-  MapElem<unsigned int,List<C> > *x = this->set_in(e);
+  MapElem<unsigned int,List<C> > *x = this->get_record(h);
   if (x)
     l = &x->value;
   else
@@ -429,11 +515,9 @@ ChainHash<C, AHashFns>::del(C c) {
 template <class K, class AHashFns, class C>  MapElem<K,C> *
 ChainHashMap<K, AHashFns, C>::put(K akey, C avalue) {
   unsigned int h = AHashFns::hash(akey);
-  List<MapElem<K,C> > empty;
   List<MapElem<K,C> > *l;
   MapElem<K, C> c(akey, avalue);
-  MapElem<unsigned int,List<MapElem<K,C> > > e(h, empty);
-  MapElem<unsigned int,List<MapElem<K,C> > > *x = this->set_in(e);
+  MapElem<unsigned int,List<MapElem<K,C> > > *x = this->get_record(h);
   if (x)
     l = &x->value;
   else {
@@ -452,9 +536,7 @@ ChainHashMap<K, AHashFns, C>::put(K akey, C avalue) {
 template <class K, class AHashFns, class C> C
 ChainHashMap<K, AHashFns, C>::get(K akey) {
   unsigned int h = AHashFns::hash(akey);
-  List<MapElem<K,C> > empty;
-  MapElem<unsigned int,List<MapElem<K,C> > > e(h, empty);
-  MapElem<unsigned int,List<MapElem<K,C> > > *x = this->set_in(e);
+  MapElem<unsigned int,List<MapElem<K,C> > > *x = this->get_record(h);
   if (!x)
     return 0;
   List<MapElem<K,C> > *l = &x->value;
@@ -468,10 +550,8 @@ ChainHashMap<K, AHashFns, C>::get(K akey) {
 template <class K, class AHashFns, class C>  int
 ChainHashMap<K, AHashFns, C>::del(K akey) {
   unsigned int h = AHashFns::hash(akey);
-  List<MapElem<K,C> > empty;
   List<MapElem<K,C> > *l;
-  MapElem<unsigned int,List<MapElem<K,C> > > e(h, empty);
-  MapElem<unsigned int,List<MapElem<K,C> > > *x = this->set_in(e);
+  MapElem<unsigned int,List<MapElem<K,C> > > *x = this->get_record(h);
   if (x)
     l = &x->value;
   else
@@ -520,8 +600,7 @@ StringChainHash::canonicalize(char *s, char *e) {
   else
     while (*a) h = h * 27 + (unsigned char)*a++;  
   List<char*> *l;
-  MapElem<unsigned int,List<char*> > me(h, (char*)0);
-  MapElem<unsigned int,List<char*> > *x = this->set_in(me);
+  MapElem<unsigned int,List<char*> > *x = this->get_record(h);
   if (x) {
     l = &x->value;
     forc_List(char *, x, *l) {
@@ -548,8 +627,7 @@ StringChainHash::canonicalize(char *s, char *e) {
 
 template <class K, class C> inline C 
 Env<K,C>::get(K akey) {
-  MapElem<K,List<C> *> e(akey, 0);
-  MapElem<K,List<C> *> *x = store.set_in(e);
+  MapElem<K,List<C> *> *x = store.get_record(akey);
   if (x)
     return x->value->first();
   return (C)0;
@@ -70,6 +70,8 @@ void freeDefUseChains(std::map<SymExpr*, Vec<SymExpr*>*>& DU,
 
 void remoteValueForwarding();
 
+void markAggregatedLoops();
+
 void inferConstRefs();
 
 
@@ -22,6 +22,7 @@
 
 #include "baseAST.h"
 #include "symbol.h"
+#include <cstdio>
 #include <vector>
 #include <map>
 
@@ -95,4 +96,7 @@ void fixupTupleFunctions(FnSymbol* fn, FnSymbol* newFn, CallExpr* call);
 AggregateType* computeNonRefTuple(Type* t);
 AggregateType* computeTupleWithIntent(IntentTag intent, Type* t);
 
+// instantiation/wrapper cache statistics (--print-passes)
+void printCacheStatistics(FILE* fp);
+
 #endif
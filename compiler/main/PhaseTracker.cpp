@@ -20,6 +20,7 @@
 #include "PhaseTracker.h"
 
 #include "baseAST.h"
+#include "compilerTrace.h"
 #include "driver.h"
 
 #include <cstdlib>
@@ -33,7 +34,8 @@ public:
                            Phase(const char*            name,
                                  int                    passId,
                                  PhaseTracker::SubPhase subPhase,
-                                 unsigned long          startTime);
+                                 unsigned long          startTime,
+                                 size_t                 startBytes);
                           ~Phase();
 
   bool                     IsStartOfPass()                            const;
@@ -48,6 +50,7 @@ public:
   int                      mPassId;
   PhaseTracker::SubPhase   mSubPhase;
   unsigned long            mStartTime;  // Elapsed time from main() usecs
+  size_t                   mStartBytes; // AST memory at the start
 
 private:
   Phase();
@@ -112,11 +115,15 @@ PhaseTracker::PhaseTracker()
   mPhaseId = 0;
 
   mTimer.start();
+  traceSetClock(&mTimer);
+
   StartPhase("startup");
 }
 
 PhaseTracker::~PhaseTracker()
 {
+  traceSetClock(0);
+
   for (size_t i = 0; i < mPhases.size(); i++)
     delete mPhases[i];
 }
@@ -140,9 +147,15 @@ void PhaseTracker::StartPhase(const char* name,
                               int         passId,
                               SubPhase    subPhase)
 {
-  Phase* phase = new Phase(name, passId, subPhase, mTimer.elapsedUsecs());
+  Phase* phase = new Phase(name,
+                           passId,
+                           subPhase,
+                           mTimer.elapsedUsecs(),
+                           astMemoryInUse());
 
   mPhases.push_back(phase);
+
+  traceSampleCounters();
 }
 
 void PhaseTracker::Stop()
@@ -179,6 +192,50 @@ void PhaseTracker::ReportRollup() const
   PassesReport(passes, totalTime);
 }
 
+// Add the phases to the regions collected by the TraceRegions and write them
+void PhaseTracker::WriteTrace(const char* filename) const
+{
+  const char* passName = 0;
+
+  for (size_t i = 0; i < mPhases.size(); i++)
+  {
+    const Phase*  phase      = mPhases[i];
+    unsigned long endTime    = mTimer.elapsedUsecs();
+    size_t        endBytes   = astMemoryInUse();
+    const char*   name       = 0;
+
+    if (i < mPhases.size() - 1)
+    {
+      endTime  = mPhases[i + 1]->mStartTime;
+      endBytes = mPhases[i + 1]->mStartBytes;
+    }
+
+    switch (phase->mSubPhase)
+    {
+      case PhaseTracker::kPrimary:
+        passName = phase->mName;
+        name     = phase->mName;
+        break;
+
+      case PhaseTracker::kVerify:
+        name     = "check";
+        break;
+
+      case PhaseTracker::kCleanAst:
+        name     = "clean";
+        break;
+    }
+
+    traceAddPhase(name,
+                  (phase->mSubPhase == PhaseTracker::kPrimary) ? "pass" : passName,
+                  phase->mStartTime,
+                  endTime,
+                  (long) endBytes - (long) phase->mStartBytes);
+  }
+
+  traceWrite(filename);
+}
+
 void PhaseTracker::PassesCollect(std::vector<Pass>& passes) const
 {
   unsigned long totalTime = mTimer.elapsedUsecs();
@@ -280,12 +337,14 @@ static void PassesReport(FILE*                    fp,
 Phase::Phase(const char*            name,
              int                    passId,
              PhaseTracker::SubPhase subPhase,
-             unsigned long          startTime)
+             unsigned long          startTime,
+             size_t                 startBytes)
 {
-  mName      = (subPhase == PhaseTracker::kPrimary) ? strdup(name) : 0;
-  mPassId    = passId;
-  mSubPhase  = subPhase;
-  mStartTime = startTime;
+  mName       = (subPhase == PhaseTracker::kPrimary) ? strdup(name) : 0;
+  mPassId     = passId;
+  mSubPhase   = subPhase;
+  mStartTime  = startTime;
+  mStartBytes = startBytes;
 }
 
 Phase::~Phase()
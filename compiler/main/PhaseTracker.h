@@ -84,6 +84,8 @@ public:
 
   void                 ReportRollup()                                const;
 
+  void                 WriteTrace(const char* filename)              const;
+
 private:
   void                 PassesCollect(std::vector<Pass>& passes) const;
   
@@ -0,0 +1,238 @@
+/*
+ * Copyright 2004-2016 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "compilerTrace.h"
+
+#include "baseAST.h"
+#include "driver.h"
+#include "misc.h"
+#include "timer.h"
+
+#include <cstdio>
+#include <vector>
+
+struct TraceEvent
+{
+  const char*   name;
+  const char*   detail;
+  const char*   category;
+  unsigned long startTime;         // usecs
+  unsigned long endTime;           // usecs
+  long          astBytes;          // change in AST memory
+};
+
+struct CounterSample
+{
+  const TraceCounter* counter;
+  unsigned long       time;        // usecs
+  long                value;
+};
+
+static void writeString(FILE* fp, const char* str);
+
+static std::vector<TraceEvent>    sEvents;
+static std::vector<CounterSample> sSamples;
+
+// Constant initialized so that static TraceCounters may register themselves
+static TraceCounter*              sCounters = 0;
+
+static const Timer*               sClock    = 0;
+
+static unsigned long traceNow()
+{
+  return (sClock != 0) ? sClock->elapsedUsecs() : 0;
+}
+
+bool traceEnabled()
+{
+  return (fCompilerTrace[0] != '\0') ? true : false;
+}
+
+void traceSetClock(const Timer* clock)
+{
+  sClock = clock;
+}
+
+/************************************* | **************************************
+*                                                                             *
+* Implementation of TraceRegion                                               *
+*                                                                             *
+************************************** | *************************************/
+
+TraceRegion::TraceRegion(const char* name, const char* detail)
+{
+  mIndex = -1;
+
+  if (traceEnabled() == true)
+  {
+    TraceEvent event;
+
+    event.name      = name;
+    event.detail    = detail;
+    event.category  = "region";
+    event.startTime = traceNow();
+    event.endTime   = event.startTime;
+    event.astBytes  = (long) astMemoryInUse();
+
+    mIndex = (int) sEvents.size();
+
+    sEvents.push_back(event);
+  }
+}
+
+TraceRegion::~TraceRegion()
+{
+  if (mIndex >= 0)
+  {
+    TraceEvent& event = sEvents[mIndex];
+
+    event.endTime  = traceNow();
+    event.astBytes = (long) astMemoryInUse() - event.astBytes;
+  }
+}
+
+/************************************* | **************************************
+*                                                                             *
+* Implementation of TraceCounter                                              *
+*                                                                             *
+************************************** | *************************************/
+
+TraceCounter::TraceCounter(const char* name)
+{
+  mName     = name;
+  mValue    = 0;
+  mNext     = sCounters;
+
+  sCounters = this;
+}
+
+void traceSampleCounters()
+{
+  if (traceEnabled() == true)
+  {
+    unsigned long now = traceNow();
+
+    for (TraceCounter* counter = sCounters; counter; counter = counter->mNext)
+    {
+      CounterSample sample;
+
+      sample.counter = counter;
+      sample.time    = now;
+      sample.value   = counter->mValue;
+
+      sSamples.push_back(sample);
+    }
+  }
+}
+
+/************************************* | **************************************
+*                                                                             *
+* The trace is written as a single JSON object in the Chrome trace event      *
+* format.  Regions and phases are "complete" (ph X) events on a single        *
+* thread; counters are "counter" (ph C) events.                               *
+*                                                                             *
+************************************** | *************************************/
+
+void traceAddPhase(const char*   name,
+                   const char*   category,
+                   unsigned long startTime,
+                   unsigned long endTime,
+                   long          astBytes)
+{
+  TraceEvent event;
+
+  event.name      = name;
+  event.detail    = 0;
+  event.category  = category;
+  event.startTime = startTime;
+  event.endTime   = endTime;
+  event.astBytes  = astBytes;
+
+  sEvents.push_back(event);
+}
+
+void traceWrite(const char* filename)
+{
+  FILE*       fp        = fopen(filename, "w");
+  const char* separator = "\n";
+
+  if (fp == NULL)
+  {
+    USR_WARN("Error opening compiler trace file: %s.", filename);
+    return;
+  }
+
+  fprintf(fp, "{\"traceEvents\":[");
+
+  for (size_t i = 0; i < sEvents.size(); i++)
+  {
+    const TraceEvent& event = sEvents[i];
+
+    fprintf(fp, "%s{\"name\":", separator);
+    writeString(fp, event.name);
+    fprintf(fp, ",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":0", event.category);
+    fprintf(fp, ",\"ts\":%lu,\"dur\":%lu", event.startTime, event.endTime - event.startTime);
+    fprintf(fp, ",\"args\":{\"astBytes\":%ld", event.astBytes);
+
+    if (event.detail != 0)
+    {
+      fprintf(fp, ",\"detail\":");
+      writeString(fp, event.detail);
+    }
+
+    fprintf(fp, "}}");
+
+    separator = ",\n";
+  }
+
+  for (size_t i = 0; i < sSamples.size(); i++)
+  {
+    const CounterSample& sample = sSamples[i];
+
+    fprintf(fp, "%s{\"name\":", separator);
+    writeString(fp, sample.counter->mName);
+    fprintf(fp, ",\"ph\":\"C\",\"pid\":0,\"ts\":%lu", sample.time);
+    fprintf(fp, ",\"args\":{\"value\":%ld}}", sample.value);
+
+    separator = ",\n";
+  }
+
+  fprintf(fp, "\n]}\n");
+
+  fclose(fp);
+}
+
+static void writeString(FILE* fp, const char* str)
+{
+  fputc('"', fp);
+
+  for (const char* ch = str; *ch != '\0'; ch++)
+  {
+    if (*ch == '"' || *ch == '\\')
+      fprintf(fp, "\\%c", *ch);
+
+    else if ((unsigned char) *ch < 0x20)
+      fprintf(fp, "\\u%04x", *ch);
+
+    else
+      fputc(*ch, fp);
+  }
+
+  fputc('"', fp);
+}
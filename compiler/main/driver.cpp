@@ -27,6 +27,7 @@
 #include "arg.h"
 #include "chpl.h"
 #include "commonFlags.h"
+#include "compilerTrace.h"
 #include "config.h"
 #include "countTokens.h"
 #include "docsDriver.h"
@@ -37,6 +38,7 @@
 #include "mysystem.h"
 #include "PhaseTracker.h"
 #include "primitive.h"
+#include "resolution.h"
 #include "runpasses.h"
 #include "stmt.h"
 #include "stringutil.h"
@@ -91,6 +93,7 @@ bool ignore_errors = false;
 bool ignore_errors_for_pass = false;
 bool ignore_warnings = false;
 int fcg = 0;
+bool fAggregateRemoteOps = false;
 static bool fBaseline = false;
 bool fCacheRemote = false;
 bool fFastFlag = false;
@@ -106,6 +109,7 @@ bool fNoOptimizeArrayIndexing = false;
 bool fNoOptimizeLoopIterators = false;
 bool fNoVectorize = true;
 bool fNoGlobalConstOpt = false;
+bool fNoHeapVarEscapeAnalysis = false;
 bool fNoFastFollowers = false;
 bool fNoInlineIterators = false;
 bool fNoLiveAnalysis = false;
@@ -133,18 +137,23 @@ static bool fNoWarnDomainLiteral = true;
 static bool fNoWarnTupleIteration = true;
 
 bool fNoloopInvariantCodeMotion = false;
+bool fLoopInvariantRemoteHoist = false;
+bool fWideArgClones = false;
 bool fNoChecks = false;
 bool fNoInline = false;
 bool fNoPrivatization = false;
 bool fNoOptimizeOnClauses = false;
 bool fNoRemoveEmptyRecords = true;
+bool fNoMemoizeResolution = false;
 bool fRemoveUnreachableBlocks = true;
 bool fMinimalModules = false;
 bool fIncrementalCompilation = false;
+int  fIncrementalPartitions  = 0;
 bool fUseIPE         = false;
 
 int optimize_on_clause_limit = 20;
 int scalar_replace_limit = 8;
+int inline_size_budget = 12;
 int tuple_copy_limit = scalar_replace_limit;
 bool fGenIDS = false;
 int fLinkStyle = LS_DEFAULT; // use backend compiler's default
@@ -168,15 +177,19 @@ bool fPrintIDonError = false;
 bool fPrintModuleResolution = false;
 bool fPrintEmittedCodeSize = false;
 char fPrintStatistics[256] = "";
+bool fPrintAstMemory = false;
+char fCompilerTrace[FILENAME_MAX+1] = "";
 bool fPrintDispatch = false;
 bool fReportOptimizedArrayIndexing = false;
 bool fReportOptimizedLoopIterators = false;
 bool fReportOrderIndependentLoops = false;
 bool fReportOptimizedOn = false;
 bool fReportPromotion = false;
+bool fReportRemoteValueForwarding = false;
 bool fReportScalarReplace = false;
 bool fReportDeadBlocks = false;
 bool fReportDeadModules = false;
+bool fReportVisibilityStats = false;
 bool printCppLineno = false;
 bool userSetCppLineno = false;
 int num_constants_per_variable = 1;
@@ -535,6 +548,7 @@ static void setBaselineFlag(const ArgumentDescription* desc, const char* unused)
   //
   fBaseline = true;                   // --baseline
 
+  fAggregateRemoteOps = false;        // --no-aggregate-remote-ops
   fNoCopyPropagation = true;          // --no-copy-propagation
   fNoDeadCodeElimination = true;      // --no-dead-code-elimination
   fNoFastFollowers = true;            // --no-fast-followers
@@ -641,6 +655,7 @@ static ArgumentDescription arg_desc[] = {
  {"local", ' ', NULL, "Target one [many] locale[s]", "N", &fLocal, "CHPL_LOCAL", setLocal},
 
  {"", ' ', NULL, "Optimization Control Options", NULL, NULL, NULL, NULL},
+ {"aggregate-remote-ops", ' ', NULL, "Enable [disable] aggregation of remote puts in forall loops", "N", &fAggregateRemoteOps, "CHPL_AGGREGATE_REMOTE_OPS", NULL},
  {"baseline", ' ', NULL, "Disable all Chapel optimizations", "F", &fBaseline, "CHPL_BASELINE", setBaselineFlag},
  {"cache-remote", ' ', NULL, "Enable cache for remote data (must be enabled specifically)", "F", &fCacheRemote, "CHPL_CACHE_REMOTE", setCacheEnable},
  {"conditional-dynamic-dispatch-limit", ' ', "<limit>", "Set limit on # of inline conditionals used for dynamic dispatch", "I", &fConditionalDynamicDispatchLimit, "CHPL_CONDITIONAL_DYNAMIC_DISPATCH_LIMIT", NULL},
@@ -652,6 +667,7 @@ static ArgumentDescription arg_desc[] = {
  {"ignore-local-classes", ' ', NULL, "Disable [enable] local classes", "N", &fIgnoreLocalClasses, NULL, NULL},
  {"inline", ' ', NULL, "Enable [disable] function inlining", "n", &fNoInline, NULL, NULL},
  {"inline-iterators", ' ', NULL, "Enable [disable] iterator inlining", "n", &fNoInlineIterators, "CHPL_DISABLE_INLINE_ITERATORS", NULL},
+ {"inline-size-budget", ' ', "<size>", "Set the size of functions inlined automatically (0 disables)", "I", &inline_size_budget, "CHPL_INLINE_SIZE_BUDGET", NULL},
  {"live-analysis", ' ', NULL, "Enable [disable] live variable analysis", "n", &fNoLiveAnalysis, "CHPL_DISABLE_LIVE_ANALYSIS", NULL},
  {"loop-invariant-code-motion", ' ', NULL, "Enable [disable] loop invariant code motion", "n", &fNoloopInvariantCodeMotion, NULL, NULL},
  {"optimize-array-indexing", ' ', NULL, "Enable [disable] array indexing optimization", "n", &fNoOptimizeArrayIndexing, "CHPL_DISABLE_OPTIMIZE_ARRAY_INDEXING", NULL},
@@ -776,6 +792,8 @@ static ArgumentDescription arg_desc[] = {
  {"print-module-resolution", ' ', NULL, "Print name of module being resolved", "F", &fPrintModuleResolution, "CHPL_PRINT_MODULE_RESOLUTION", NULL},
  {"print-dispatch", ' ', NULL, "Print dynamic dispatch table", "F", &fPrintDispatch, NULL, NULL},
  {"print-statistics", ' ', "[n|k|t]", "Print AST statistics", "S256", fPrintStatistics, NULL, NULL},
+ {"print-ast-memory", ' ', NULL, "Print peak and live AST memory after each pass", "F", &fPrintAstMemory, NULL, NULL},
+ {"compiler-trace", ' ', "<filename>", "Write a Chrome trace of passes and trace regions to <filename>", "P", fCompilerTrace, "CHPL_COMPILER_TRACE", NULL},
  {"report-inlining", ' ', NULL, "Print inlined functions", "F", &report_inlining, NULL, NULL},
  {"report-dead-blocks", ' ', NULL, "Print dead block removal stats", "F", &fReportDeadBlocks, NULL, NULL},
  {"report-dead-modules", ' ', NULL, "Print dead module removal stats", "F", &fReportDeadModules, NULL, NULL},
@@ -784,7 +802,9 @@ static ArgumentDescription arg_desc[] = {
  {"report-order-independent-loops", ' ', NULL, "Print stats on order independent loops", "F", &fReportOrderIndependentLoops, NULL, NULL},
  {"report-optimized-on", ' ', NULL, "Print information about on clauses that have been optimized for potential fast remote fork operation", "F", &fReportOptimizedOn, NULL, NULL},
  {"report-promotion", ' ', NULL, "Print information about scalar promotion", "F", &fReportPromotion, NULL, NULL},
+ {"report-remote-value-forwarding", ' ', NULL, "Print the number of remote reads removed from each on clause by remote value forwarding", "F", &fReportRemoteValueForwarding, NULL, NULL},
  {"report-scalar-replace", ' ', NULL, "Print scalar replacement stats", "F", &fReportScalarReplace, NULL, NULL},
+ {"report-visibility-stats", ' ', NULL, "Print visible function lookup stats", "F", &fReportVisibilityStats, NULL, NULL},
 
  {"", ' ', NULL, "Developer Flags -- Miscellaneous", NULL, NULL, NULL, NULL},
  {"break-on-id", ' ', NULL, "Break when AST id is created", "I", &breakOnID, "CHPL_BREAK_ON_ID", NULL},
@@ -796,6 +816,7 @@ static ArgumentDescription arg_desc[] = {
  {"break-on-resolve-id", ' ', NULL, "Break when function call with AST id is resolved", "I", &breakOnResolveID, "CHPL_BREAK_ON_RESOLVE_ID", NULL},
  {"denormalize", ' ', NULL, "Enable [disable] denormalization", "N", &fDenormalize, "CHPL_DENORMALIZE", NULL},
  DRIVER_ARG_DEBUGGERS,
+ {"heap-var-escape-analysis", ' ', NULL, "Enable [disable] bounding the lifetime of heap-allocated locals by the tasks that use them", "n", &fNoHeapVarEscapeAnalysis, "CHPL_DISABLE_HEAP_VAR_ESCAPE_ANALYSIS", NULL},
  {"heterogeneous", ' ', NULL, "Compile for heterogeneous nodes", "F", &fHeterogeneous, "", NULL},
  {"ignore-errors", ' ', NULL, "[Don't] attempt to ignore errors", "N", &ignore_errors, "CHPL_IGNORE_ERRORS", NULL},
  {"ignore-errors-for-pass", ' ', NULL, "[Don't] attempt to ignore errors until the end of the pass in which they occur", "N", &ignore_errors_for_pass, "CHPL_IGNORE_ERRORS_FOR_PASS", NULL},
@@ -803,13 +824,17 @@ static ArgumentDescription arg_desc[] = {
  {"localize-global-consts", ' ', NULL, "Enable [disable] optimization of global constants", "n", &fNoGlobalConstOpt, "CHPL_DISABLE_GLOBAL_CONST_OPT", NULL},
  {"local-temp-names", ' ', NULL, "[Don't] Generate locally-unique temp names", "N", &localTempNames, "CHPL_LOCAL_TEMP_NAMES", NULL},
  {"log-deleted-ids-to", ' ', "<filename>", "Log AST id and memory address of each deleted node to the specified file", "P", deletedIdFilename, "CHPL_DELETED_ID_FILENAME", NULL},
+ {"loop-invariant-remote-hoist", ' ', NULL, "Enable [disable] hoisting reads of constructor-initialized class fields out of loops", "N", &fLoopInvariantRemoteHoist, "CHPL_LOOP_INVARIANT_REMOTE_HOIST", NULL},
+ {"memoize-resolution", ' ', NULL, "Enable [disable] reuse of resolution results for calls with identical signatures", "n", &fNoMemoizeResolution, "CHPL_DISABLE_MEMOIZE_RESOLUTION", NULL},
  {"memory-frees", ' ', NULL, "Enable [disable] memory frees in the generated code", "n", &fNoMemoryFrees, "CHPL_DISABLE_MEMORY_FREES", NULL},
  {"preserve-inlined-line-numbers", ' ', NULL, "[Don't] Preserve file names/line numbers in inlined code", "N", &preserveInlinedLineNumbers, "CHPL_PRESERVE_INLINED_LINE_NUMBERS", NULL},
  {"print-id-on-error", ' ', NULL, "[Don't] print AST id in error messages", "N", &fPrintIDonError, "CHPL_PRINT_ID_ON_ERROR", NULL},
  {"remove-empty-records", ' ', NULL, "Enable [disable] empty record removal", "n", &fNoRemoveEmptyRecords, "CHPL_DISABLE_REMOVE_EMPTY_RECORDS", NULL},
  {"remove-unreachable-blocks", ' ', NULL, "[Don't] remove unreachable blocks after resolution", "N", &fRemoveUnreachableBlocks, "CHPL_REMOVE_UNREACHABLE_BLOCKS", NULL},
  {"replace-array-accesses-with-ref-temps", ' ', NULL, "Enable [disable] replacing array accesses with reference temps (experimental)", "N", &fReplaceArrayAccessesWithRefTemps, NULL, NULL },
+ {"wide-arg-clones", ' ', NULL, "Enable [disable] cloning functions for calls that pass them wide arguments", "N", &fWideArgClones, "CHPL_WIDE_ARG_CLONES", NULL},
  {"incremental", ' ', NULL, "Enable [disable] using incremental compilation", "N", &fIncrementalCompilation, "CHPL_INCREMENTAL_COMP", NULL},
+ {"incremental-partitions", ' ', "<n>", "Number of translation units for incremental compilation (default: one per processor)", "I", &fIncrementalPartitions, "CHPL_INCREMENTAL_PARTITIONS", NULL},
  {"minimal-modules", ' ', NULL, "Enable [disable] using minimal modules",               "N", &fMinimalModules, "CHPL_MINIMAL_MODULES", NULL},
  DRIVER_ARG_PRINT_CHPL_HOME,
  DRIVER_ARG_LAST
@@ -1154,10 +1179,19 @@ int main(int argc, char* argv[]) {
 
   tracker.Stop();
 
+  if (traceEnabled() == true)
+    tracker.WriteTrace(fCompilerTrace);
+
   if (printPasses == true || printPassesFile != NULL) {
     tracker.ReportPass();
     tracker.ReportTotal();
     tracker.ReportRollup();
+
+    if (printPasses == true)
+      printCacheStatistics(stderr);
+
+    if (printPassesFile != NULL)
+      printCacheStatistics(printPassesFile);
   }
 
   if (printPassesFile != NULL) {
@@ -230,6 +230,9 @@ static void runPass(PhaseTracker& tracker, size_t passIndex, bool isChpldoc) {
     cleanAst();
   }
 
+  if (fPrintAstMemory)
+    printAstMemory(info->name);
+
   if (printPasses == true || printPassesFile != 0) {
     tracker.ReportPass();
   }
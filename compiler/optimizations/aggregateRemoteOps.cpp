@@ -0,0 +1,263 @@
+/*
+ * Copyright 2004-2016 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// Choose the loops whose remote PUTs are aggregated (--aggregate-remote-ops).
+//
+// The remote PUTs of an aggregated loop are buffered per destination node by
+// the runtime (chpl-comm-aggregate.c) and sent in bulk when a buffer fills
+// and when the loop ends.  Until then, every other GET and PUT by the task
+// first sends the buffered PUTs it overlaps, and a remote 'on' sends them
+// all, so the task still sees its own writes in order.
+//
+// A loop is aggregated if
+//
+//   - it is order independent, e.g. the follower loop of a forall, so the
+//     order in which its iterations' PUTs complete does not matter;
+//   - it writes through a wide reference, so there is something to buffer;
+//   - no other task could expect to see its PUTs before it ends.  It, and
+//     the functions it calls, may not start tasks or use sync variables,
+//     atomics or communication that bypasses chpl_gen_comm_get/put(), and
+//     nothing but the end of the loop leaves it.
+//
+// Only the outermost of nested aggregated loops is marked.  The aggregator
+// is declared around the loop by the C code generator.
+//
+
+#include "optimizations.h"
+
+#include "astutil.h"
+#include "driver.h"
+#include "expr.h"
+#include "LoopStmt.h"
+#include "stlUtil.h"
+#include "stmt.h"
+
+#include <cstring>
+#include <map>
+#include <set>
+#include <vector>
+
+static void findUnaggregatableFns(std::set<FnSymbol*>& unaggregatable);
+static bool isAggregatableLoop(LoopStmt*            loop,
+                               std::set<FnSymbol*>& unaggregatable);
+static bool writesRemote(CallExpr* call);
+static bool isAggregatableCall(CallExpr* call);
+static bool leavesLoop(LoopStmt* loop, GotoStmt* gotoStmt);
+
+void markAggregatedLoops() {
+  std::set<FnSymbol*> unaggregatable;
+  std::set<LoopStmt*> loops;
+
+  findUnaggregatableFns(unaggregatable);
+
+  forv_Vec(BlockStmt, block, gBlockStmts) {
+    if (LoopStmt* loop = toLoopStmt(block)) {
+      if (isAggregatableLoop(loop, unaggregatable) == true) {
+        loops.insert(loop);
+      }
+    }
+  }
+
+  for (std::set<LoopStmt*>::iterator it = loops.begin();
+       it != loops.end();
+       ++it) {
+    LoopStmt* loop      = *it;
+    bool      outermost = true;
+
+    for (Expr* expr = loop->parentExpr; expr; expr = expr->parentExpr) {
+      if (LoopStmt* outer = toLoopStmt(expr)) {
+        if (loops.count(outer) == 1) {
+          outermost = false;
+        }
+      }
+    }
+
+    loop->aggregateRemoteOpsSet(outermost);
+  }
+}
+
+//
+// A function cannot be called while PUTs are buffered if it, or any
+// function it calls, makes a call that cannot.
+//
+static void findUnaggregatableFns(std::set<FnSymbol*>& unaggregatable) {
+  std::map<FnSymbol*, std::vector<FnSymbol*> > callers;
+  std::vector<FnSymbol*>                       worklist;
+
+  forv_Vec(FnSymbol, fn, gFnSymbols) {
+    if (fn->inTree() == true) {
+      std::vector<CallExpr*> calls;
+      bool                   ok = true;
+
+      collectCallExprs(fn->body, calls);
+
+      for_vector(CallExpr, call, calls) {
+        if (isAggregatableCall(call) == false) {
+          ok = false;
+
+        } else if (FnSymbol* callee = call->isResolved()) {
+          callers[callee].push_back(fn);
+        }
+      }
+
+      if (ok == false) {
+        unaggregatable.insert(fn);
+        worklist.push_back(fn);
+      }
+    }
+  }
+
+  while (worklist.empty() == false) {
+    FnSymbol* fn = worklist.back();
+
+    worklist.pop_back();
+
+    for_vector(FnSymbol, caller, callers[fn]) {
+      if (unaggregatable.insert(caller).second == true) {
+        worklist.push_back(caller);
+      }
+    }
+  }
+}
+
+static bool isAggregatableLoop(LoopStmt*            loop,
+                               std::set<FnSymbol*>& unaggregatable) {
+  FnSymbol* fn     = toFnSymbol(loop->parentSymbol);
+  bool      writes = false;
+  bool      retval = false;
+
+  if (loop->isOrderIndependent() == true &&
+      fn                         != NULL &&
+      loop                       != fn->body &&
+      loop->inTree()             == true) {
+    std::vector<BaseAST*> asts;
+
+    collect_asts(loop, asts);
+
+    retval = true;
+
+    for_vector(BaseAST, ast, asts) {
+      if (CallExpr* call = toCallExpr(ast)) {
+        if (call->isPrimitive(PRIM_RETURN) == true) {
+          retval = false;
+
+        } else if (writesRemote(call) == true) {
+          writes = true;
+
+        } else if (isAggregatableCall(call) == false) {
+          retval = false;
+
+        } else if (FnSymbol* callee = call->isResolved()) {
+          if (unaggregatable.count(callee) == 1) {
+            retval = false;
+          }
+        }
+
+      } else if (GotoStmt* gotoStmt = toGotoStmt(ast)) {
+        if (leavesLoop(loop, gotoStmt) == true) {
+          retval = false;
+        }
+      }
+    }
+  }
+
+  return retval && writes;
+}
+
+// Is this a store through a wide reference, i.e. a PUT?
+static bool writesRemote(CallExpr* call) {
+  bool retval = false;
+
+  if (call->isPrimitive(PRIM_MOVE)   == true ||
+      call->isPrimitive(PRIM_ASSIGN) == true) {
+    retval = call->get(1)->isWideRef()      == true &&
+             call->get(2)->isRefOrWideRef() == false;
+
+  } else if (call->isPrimitive(PRIM_SET_MEMBER)      == true ||
+             call->isPrimitive(PRIM_SET_SVEC_MEMBER) == true) {
+    Type* baseType = call->get(1)->typeInfo();
+
+    retval = call->get(1)->isWideRef()                 == true ||
+             baseType->symbol->hasFlag(FLAG_WIDE_CLASS) == true;
+  }
+
+  return retval;
+}
+
+//
+// Can the call itself be made while PUTs are buffered?  The functions it
+// calls are considered by findUnaggregatableFns().
+//
+static bool isAggregatableCall(CallExpr* call) {
+  bool retval = false;
+
+  if (call->primitive != NULL) {
+    switch (call->primitive->tag) {
+      case PRIM_CHPL_COMM_GET_STRD:
+      case PRIM_CHPL_COMM_PUT_STRD:
+      case PRIM_ARRAY_ALLOC:
+      case PRIM_ARRAY_FREE:
+      case PRIM_FTABLE_CALL:
+      case PRIM_VIRTUAL_METHOD_CALL:
+        retval = false;
+        break;
+
+      case PRIM_STRING_COPY:
+        retval = call->get(1)->typeInfo()->symbol->hasFlag(FLAG_WIDE_CLASS) ==
+                 false;
+        break;
+
+      default:
+        retval = true;
+        break;
+    }
+
+  } else if (FnSymbol* fn = call->isResolved()) {
+    if (fn->hasFlag(FLAG_EXTERN) == true) {
+      retval = strncmp(fn->cname, "chpl_comm",         9) != 0 &&
+               strncmp(fn->cname, "chpl_sync",         9) != 0 &&
+               strncmp(fn->cname, "chpl_rmem_consist", 17) != 0 &&
+               strncmp(fn->cname, "atomic_",           7) != 0;
+
+    } else {
+      retval = fn->hasFlag(FLAG_BEGIN)               == false &&
+               fn->hasFlag(FLAG_COBEGIN_OR_COFORALL) == false &&
+               fn->hasFlag(FLAG_NON_BLOCKING)        == false;
+    }
+  }
+
+  return retval;
+}
+
+// The aggregator is flushed after the loop, which a goto must not skip
+static bool leavesLoop(LoopStmt* loop, GotoStmt* gotoStmt) {
+  LabelSymbol* target = gotoStmt->gotoTarget();
+  bool         retval = true;
+
+  if (target != NULL) {
+    for (Expr* expr = target->defPoint; expr; expr = expr->parentExpr) {
+      if (expr == loop) {
+        retval = false;
+      }
+    }
+  }
+
+  return retval;
+}
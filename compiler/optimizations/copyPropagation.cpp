@@ -24,6 +24,7 @@
 #include "astutil.h"
 #include "bb.h"
 #include "bitVec.h"
+#include "compilerTrace.h"
 #include "expr.h"
 #include "passes.h"
 #include "stlUtil.h"
@@ -129,6 +130,8 @@
 static size_t s_repl_count; ///< The number of pairs replaced by GCP this pass.
 static size_t s_ref_repl_count; ///< The number of references replaced this pass.
 
+static TraceCounter copiesPropagated("copies propagated");
+
 
 //#############################################################################
 //# LOCAL COPY PROPAGATION
@@ -883,7 +886,8 @@ localCopyPropagationCore(BasicBlock*          bb,
 //
 size_t localCopyPropagation(FnSymbol* fn)
 {
-  RefMap refs;
+  TraceRegion region("localCopyPropagation", fn->name);
+  RefMap      refs;
 
   BasicBlock::buildBasicBlocks(fn);
 
@@ -899,6 +903,8 @@ size_t localCopyPropagation(FnSymbol* fn)
     localCopyPropagationCore(bb1, available, ravailable, refs);
   }
 
+  copiesPropagated.Add(s_repl_count + s_ref_repl_count);
+
   return s_repl_count + s_ref_repl_count;
 }
 
@@ -1087,7 +1093,8 @@ static void initInSets(std::vector<BitVec*>& IN, FnSymbol* fn)
 // immediately after it would be redundant.
 //
 size_t globalCopyPropagation(FnSymbol* fn) {
-  RefMap refs;
+  TraceRegion region("globalCopyPropagation", fn->name);
+  RefMap      refs;
 
   BasicBlock::buildBasicBlocks(fn);
 
@@ -1188,6 +1195,8 @@ size_t globalCopyPropagation(FnSymbol* fn) {
   destroyPairSet(IN);
   destroyPairSet(OUT);
 
+  copiesPropagated.Add(s_repl_count + s_ref_repl_count);
+
   return s_repl_count + s_ref_repl_count;
 }
 
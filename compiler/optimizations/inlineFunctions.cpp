@@ -26,19 +26,23 @@
 #include "stmt.h"
 #include "stringutil.h"
 
+#include <algorithm>
+#include <climits>
 #include <set>
 #include <vector>
 
 static void updateRefCalls();
 static void inlineFunctionsImpl();
 static void inlineFunction(FnSymbol* fn, std::set<FnSymbol*>& inlinedSet);
-static void inlineCall(CallExpr* call);
+static void autoInlineFunctionsImpl();
+static void inlineCall(CallExpr* call, bool resetLineNumbers);
 static void updateDerefCalls();
 static void inlineCleanup();
 
 /************************************* | **************************************
 *                                                                             *
 * inline all functions with the inline flag                                   *
+* inline other small functions at the call sites they are within budget for  *
 * remove unnecessary block statements and gotos                               *
 *                                                                             *
 ************************************** | *************************************/
@@ -50,6 +54,8 @@ void inlineFunctions() {
 
   inlineFunctionsImpl();
 
+  autoInlineFunctionsImpl();
+
   updateDerefCalls();
 
   inlineCleanup();
@@ -155,7 +161,7 @@ static void simplifyBody(FnSymbol* fn) {
 static void inlineAtCallSites(FnSymbol* fn) {
   forv_Vec(CallExpr, call, *fn->calledBy) {
     if (call->isResolved()) {
-      inlineCall(call);
+      inlineCall(call, preserveInlinedLineNumbers == false);
 
       if (report_inlining) {
         printf("chapel compiler: reporting inlining, "
@@ -166,15 +172,293 @@ static void inlineAtCallSites(FnSymbol* fn) {
   }
 }
 
+/************************************* | **************************************
+*                                                                             *
+* Inline small functions that are not marked inline (--inline-size-budget).   *
+*                                                                             *
+* The size of a function is the number of calls in its body.  It is inlined   *
+* at a call if its size is within the budget for that call, which is          *
+*                                                                             *
+*   --inline-size-budget                                                      *
+*   + the same again for each loop around the call, up to two, since the      *
+*     call overhead is paid on every iteration                                *
+*   + the same again if this is the only call, as the function is then       *
+*     pruned rather than duplicated                                           *
+*   + half of it if an actual is a constant or a local record, which copy     *
+*     propagation or scalar replacement can then follow into the body         *
+*                                                                             *
+* Callees are visited before their callers, so a function is sized after the  *
+* small functions that it calls have been inlined into it.                    *
+*                                                                             *
+************************************** | *************************************/
+
+static void orderCallees(FnSymbol*               fn,
+                         std::set<FnSymbol*>&    visited,
+                         std::vector<FnSymbol*>& order);
+static bool isAutoInlineCandidate(FnSymbol* fn);
+static bool isRecognizedByLaterPasses(FnSymbol* fn);
+static bool canAutoInlineCall(CallExpr* call, FnSymbol* fn);
+static bool isUserCode(FnSymbol* fn);
+static bool isInCForLoopClause(CallExpr* call);
+static int  inlineSize(FnSymbol* fn);
+static int  inlineBudget(CallExpr* call, FnSymbol* fn);
+static int  loopDepth(CallExpr* call);
+static bool exposesActuals(CallExpr* call);
+static void copyValueActuals(CallExpr* call);
+
+static void autoInlineFunctionsImpl() {
+  if (fNoInline == false && inline_size_budget > 0) {
+    std::set<FnSymbol*>    visited;
+    std::vector<FnSymbol*> order;
+
+    // The calls copied by inlining functions with the inline flag
+    compute_call_sites();
+
+    forv_Vec(FnSymbol, fn, gFnSymbols) {
+      orderCallees(fn, visited, order);
+    }
+
+    for_vector(FnSymbol, fn, order) {
+      if (isAutoInlineCandidate(fn) == true) {
+        int size = inlineSize(fn);
+
+        forv_Vec(CallExpr, call, *fn->calledBy) {
+          if (canAutoInlineCall(call, fn) == true) {
+            int budget = inlineBudget(call, fn);
+
+            if (size <= budget) {
+              if (report_inlining) {
+                printf("chapel compiler: reporting inlining, "
+                       "%s function was inlined automatically "
+                       "(size %d, budget %d)\n",
+                       fn->cname,
+                       size,
+                       budget);
+              }
+
+              copyValueActuals(call);
+
+              inlineCall(call, isUserCode(fn) == false);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+// Order the functions reachable from fn so that callees come first
+static void orderCallees(FnSymbol*               fn,
+                         std::set<FnSymbol*>&    visited,
+                         std::vector<FnSymbol*>& order) {
+  if (visited.insert(fn).second == true) {
+    std::vector<CallExpr*> calls;
+
+    collectFnCalls(fn, calls);
+
+    for_vector(CallExpr, call, calls) {
+      if (FnSymbol* callee = call->isResolved()) {
+        orderCallees(callee, visited, order);
+      }
+    }
+
+    order.push_back(fn);
+  }
+}
+
+static bool isAutoInlineCandidate(FnSymbol* fn) {
+  bool retval = false;
+
+  if (fn->inTree()                                 == true  &&
+      fn->hasFlag(FLAG_INLINE)                     == false &&
+      fn->hasFlag(FLAG_EXTERN)                     == false &&
+      fn->hasFlag(FLAG_EXPORT)                     == false &&
+      fn->hasFlag(FLAG_NO_CODEGEN)                 == false &&
+      fn->hasFlag(FLAG_LOCAL_ARGS)                 == false &&
+      fn->hasFlag(FLAG_MODULE_INIT)                == false &&
+      fn->hasFlag(FLAG_BEGIN_BLOCK)                == false &&
+      fn->hasFlag(FLAG_ON_BLOCK)                   == false &&
+      fn->hasFlag(FLAG_COBEGIN_OR_COFORALL_BLOCK)  == false &&
+      isTaskFun(fn)                                == false &&
+      isRecognizedByLaterPasses(fn)                == false &&
+      fn                                           != chpl_gen_main) {
+    CallExpr* last = toCallExpr(fn->body->body.tail);
+
+    retval = last != NULL && last->isPrimitive(PRIM_RETURN) == true;
+  }
+
+  return retval;
+}
+
+// Later passes look for calls to these, e.g. scalarReplace() for the
+// allocation and free of an iterator class
+static bool isRecognizedByLaterPasses(FnSymbol* fn) {
+  return fn->hasFlag(FLAG_ALLOCATOR)                            == true ||
+         fn->hasFlag(FLAG_LOCALE_MODEL_ALLOC)                   == true ||
+         fn->hasFlag(FLAG_LOCALE_MODEL_FREE)                    == true ||
+         fn->hasFlag(FLAG_AUTO_COPY_FN)                         == true ||
+         fn->hasFlag(FLAG_INIT_COPY_FN)                         == true ||
+         fn->hasFlag(FLAG_AUTO_DESTROY_FN)                      == true ||
+         fn->hasFlag(FLAG_DESTRUCTOR)                           == true ||
+         fn->hasFlag(FLAG_REMOVABLE_ARRAY_ACCESS)               == true ||
+         fn->hasFlag(FLAG_DONT_DISABLE_REMOTE_VALUE_FORWARDING) == true ||
+         fn->hasFlag(FLAG_WRAPPER_NEEDS_START_FENCE)            == true ||
+         fn->hasFlag(FLAG_WRAPPER_NEEDS_FINISH_FENCE)           == true;
+}
+
+static bool canAutoInlineCall(CallExpr* call, FnSymbol* fn) {
+  FnSymbol* caller = toFnSymbol(call->parentSymbol);
+  bool      retval = false;
+
+  // Functions with the inline flag are removed after inlining
+  if (call->isResolved() == fn    &&
+      call->inTree()     == true  &&
+      caller             != NULL  &&
+      caller             != fn    &&
+      (caller->hasFlag(FLAG_INLINE)  == false ||
+       caller->hasFlag(FLAG_VIRTUAL) == true)) {
+    // The calls in user code report their own line numbers
+    retval = (isUserCode(fn) == false || isUserCode(caller) == true) &&
+             isInCForLoopClause(call) == false;
+
+    for_formals_actuals(formal, actual, call) {
+      if ((formal->intent & INTENT_REF) == 0     &&
+          formal->isRef()               == false &&
+          (actual->isRef()              == true ||
+           actual->typeInfo()           != formal->type)) {
+        retval = false;
+      }
+    }
+  }
+
+  return retval;
+}
+
+// As in insertLineNumbers()
+static bool isUserCode(FnSymbol* fn) {
+  return fn->getModule()->modTag             == MOD_USER &&
+         fn->hasFlag(FLAG_COMPILER_GENERATED) == false;
+}
+
+// The body cannot be inserted into the header of a C for loop
+static bool isInCForLoopClause(CallExpr* call) {
+  bool retval = false;
+
+  for (Expr* expr = call->parentExpr; expr != NULL; expr = expr->parentExpr) {
+    if (BlockStmt* block = toBlockStmt(expr)) {
+      if (block->blockTag == BLOCK_C_FOR_LOOP) {
+        retval = true;
+      }
+    }
+  }
+
+  return retval;
+}
+
+// The number of calls in the body, or INT_MAX if the function calls itself
+static int inlineSize(FnSymbol* fn) {
+  std::vector<CallExpr*> calls;
+  int                    retval = 0;
+
+  collectCallExprs(fn->body, calls);
+
+  for_vector(CallExpr, call, calls) {
+    if (call->isResolved() == fn) {
+      retval = INT_MAX;
+      break;
+    }
+
+    retval = retval + 1;
+  }
+
+  return retval;
+}
+
+static int inlineBudget(CallExpr* call, FnSymbol* fn) {
+  int retval = inline_size_budget;
+
+  retval = retval + inline_size_budget * std::min(loopDepth(call), 2);
+
+  if (fn->calledBy->n == 1) {
+    retval = retval + inline_size_budget;
+  }
+
+  if (exposesActuals(call) == true) {
+    retval = retval + inline_size_budget / 2;
+  }
+
+  return retval;
+}
+
+static int loopDepth(CallExpr* call) {
+  int retval = 0;
+
+  for (Expr* expr = call->parentExpr; expr != NULL; expr = expr->parentExpr) {
+    if (isLoopStmt(expr) == true) {
+      retval = retval + 1;
+    }
+  }
+
+  return retval;
+}
+
+static bool exposesActuals(CallExpr* call) {
+  bool retval = false;
+
+  for_actuals(actual, call) {
+    Symbol* sym = toSymExpr(actual)->symbol();
+
+    if (sym->isImmediate() == true) {
+      retval = true;
+
+    } else if (isVarSymbol(sym)                             == true  &&
+               isGlobal(sym)                                == false &&
+               sym->isRef()                                 == false &&
+               (isRecord(sym->type)                         == true ||
+                sym->type->symbol->hasFlag(FLAG_STAR_TUPLE) == true)) {
+      retval = true;
+    }
+  }
+
+  return retval;
+}
+
+//
+// The body may read a formal passed by value after the actual has been
+// changed, e.g. through a ref formal, so pass a copy as the call would.
+// Copy propagation removes the copies that turn out to be unnecessary.
+//
+static void copyValueActuals(CallExpr* call) {
+  Expr* stmt = call->getStmtExpr();
+
+  SET_LINENO(call);
+
+  for_formals_actuals(formal, actual, call) {
+    Symbol* sym = toSymExpr(actual)->symbol();
+
+    if ((formal->intent & INTENT_REF) == 0             &&
+        formal->isRef()               == false         &&
+        formal->type                  != dtMethodToken &&
+        sym->isImmediate()            == false) {
+      VarSymbol* tmp = newTemp("inlineArg", formal->type);
+
+      actual->replace(new SymExpr(tmp));
+
+      stmt->insertBefore(new DefExpr(tmp));
+      stmt->insertBefore(new CallExpr(PRIM_MOVE, tmp, actual));
+    }
+  }
+}
+
 /************************************* | **************************************
 *                                                                             *
 * inlines the function called by 'call' at that call site                     *
 *                                                                             *
 ************************************** | *************************************/
 
-static BlockStmt* copyBody(CallExpr* call);
+static BlockStmt* copyBody(CallExpr* call, bool resetLineNumbers);
 
-static void inlineCall(CallExpr* call) {
+static void inlineCall(CallExpr* call, bool resetLineNumbers) {
   SET_LINENO(call);
 
   //
@@ -191,7 +475,7 @@ static void inlineCall(CallExpr* call) {
   Expr*      stmt  = call->getStmtExpr();
 
   FnSymbol*  fn    = call->resolvedFunction();
-  BlockStmt* block = copyBody(call);
+  BlockStmt* block = copyBody(call, resetLineNumbers);
 
   // Transfer most of the statements from the body to immediately before
   // the statement that that contains the call.
@@ -226,7 +510,7 @@ static void inlineCall(CallExpr* call) {
 // choose to always replace an actual immediate with a temp.
 //
 
-static BlockStmt* copyBody(CallExpr* call) {
+static BlockStmt* copyBody(CallExpr* call, bool resetLineNumbers) {
   SET_LINENO(call);
 
   SymbolMap  map;
@@ -255,7 +539,7 @@ static BlockStmt* copyBody(CallExpr* call) {
 
   retval = fn->body->copy(&map);
 
-  if (preserveInlinedLineNumbers == false) {
+  if (resetLineNumbers == true) {
     reset_ast_loc(retval, call);
   }
 
@@ -22,6 +22,7 @@
 #include "astutil.h"
 #include "bb.h"
 #include "bitVec.h"
+#include "compilerTrace.h"
 #include "expr.h"
 #include "stlUtil.h"
 #include "stmt.h"
@@ -48,6 +49,8 @@ liveVariableAnalysis(FnSymbol* fn,
                      Vec<SymExpr*>& useSet,
                      Vec<SymExpr*>& defSet,
                      std::vector<BitVec*>& OUT) {
+  TraceRegion region("liveVariableAnalysis", fn->name);
+
   BasicBlock::buildLocalsVectorMap(fn, locals, localMap);
 
 #ifdef DEBUG_LIVE
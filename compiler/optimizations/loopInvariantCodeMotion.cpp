@@ -24,6 +24,7 @@
 #include "bitVec.h"
 #include "CForLoop.h"
 #include "dominator.h"
+#include "driver.h"
 #include "expr.h"
 #include "ForLoop.h"
 #include "ParamForLoop.h"
@@ -206,6 +207,10 @@ public:
 typedef std::vector<BasicBlock*> BasicBlocks;
 typedef std::map<Symbol*,std::vector<SymExpr*>*> symToVecSymExprMap;
 
+//The class fields that are only ever written by constructors.
+//Empty unless --loop-invariant-remote-hoist.
+static std::set<Symbol*> writeOnceFields;
+
 //These two functions are used to collect all natural loops from a bunch of basic blocks and ensure the loops are stored 
 //from most nested to least nested for any give loop nest 
 void collectNaturalLoops(std::vector<Loop*>& loops, BasicBlocks& basicBlocks, BasicBlock* entryBlock, std::vector<BitVec*>& dominators);
@@ -348,7 +353,14 @@ rhsAlias(CallExpr* call) {
           // get_svec's second argument is the integer offset to the field,
           // instead of the field itself. We need to return the field so that
           // we note that the lhs aliases the field and not just an integer 
-          return getSvecSymbol(rhsCall);
+          // If the offset is not a constant, it aliases the whole tuple
+          if (Symbol* field = getSvecSymbol(rhsCall)) {
+            return field;
+          } else {
+            SymExpr* rhs = toSymExpr(rhsCall->get(1));
+            INT_ASSERT(rhs);
+            return rhs->symbol();
+          }
         } else if(rhsCall->isPrimitive(PRIM_ADDR_OF)) {
           SymExpr* rhs = toSymExpr(rhsCall->get(1));
           INT_ASSERT(rhs);
@@ -488,6 +500,20 @@ static void addDefOrUse(symToVecSymExprMap& localDefOrUseMap, Symbol* var, SymEx
 }
 
 
+/*
+ * Is the actual for this formal copied into the callee?
+ */
+static bool isPassedByValue(ArgSymbol* formal) {
+  if(formal->isRef()) {
+    return false;
+  }
+  return formal->intent == INTENT_BLANK    ||
+         formal->intent == INTENT_CONST    ||
+         formal->intent == INTENT_IN       ||
+         formal->intent == INTENT_CONST_IN;
+}
+
+
 /*
  * Build the local def use maps for a loop and while we're at it build the local map which is the map from each
  * symExpr to the block it it is defined in.
@@ -502,7 +528,17 @@ static void buildLocalDefUseMaps(Loop* loop, symToVecSymExprMap& localDefMap, sy
            callExpr->isPrimitive(PRIM_SET_SVEC_MEMBER)) {
           if(SymExpr* symExpr = toSymExpr(callExpr->get(2))) {
             if(callExpr->isPrimitive(PRIM_SET_SVEC_MEMBER)) {
-              addDefOrUse(localDefMap, getSvecSymbol(callExpr), symExpr);
+              if (Symbol* field = getSvecSymbol(callExpr)) {
+                addDefOrUse(localDefMap, field, symExpr);
+              } else {
+                //the offset is not a constant, so any field may be defed
+                Type* type = callExpr->get(1)->getValType();
+                if (AggregateType* tuple = toAggregateType(type)) {
+                  for_fields(field, tuple) {
+                    addDefOrUse(localDefMap, field, symExpr);
+                  }
+                }
+              }
             } else {
               addDefOrUse(localDefMap, symExpr->symbol(), symExpr);
             }
@@ -542,12 +578,22 @@ static void buildLocalDefUseMaps(Loop* loop, symToVecSymExprMap& localDefMap, sy
             //if we have a function call, assume any "classes" fields are changed
             if(CallExpr* callExpr = toCallExpr(symExpr->parentExpr)) {
               if(callExpr->isResolved()) {
-                addDefOrUse(localDefMap, symExpr->symbol(), symExpr);
                 Type* type = symExpr->symbol()->type->symbol->type;
-                if(AggregateType* curClass = toAggregateType(type)) {
+                AggregateType* curClass = toAggregateType(type);
+
+                //a class instance passed by value can't be changed by the
+                //call
+                if(fLoopInvariantRemoteHoist == false ||
+                   curClass == NULL || curClass->isClass() == false ||
+                   isPassedByValue(actual_to_formal(symExpr)) == false) {
+                  addDefOrUse(localDefMap, symExpr->symbol(), symExpr);
+                }
+                if(curClass) {
                   for_alist(classField, curClass->fields) {
                     if(DefExpr* classFieldDef = toDefExpr(classField)) {
-                      addDefOrUse(localDefMap, classFieldDef->sym, symExpr);
+                      if(writeOnceFields.count(classFieldDef->sym) == 0) {
+                        addDefOrUse(localDefMap, classFieldDef->sym, symExpr);
+                      }
                     }
                   }
                 }
@@ -1092,6 +1138,26 @@ static bool canPerformCodeMotion(Loop* loop) {
 }
 
 
+/*
+ * With --loop-invariant-remote-hoist, a call that is passed a class instance
+ * does not kill the fields that are only written while an instance is being
+ * constructed, see collectWriteOnceFields().
+ *
+ * These are typically the descriptor fields of distributed arrays and
+ * domains (the domain of an array, the bounds of a domain, the per-locale
+ * instances) that are read through _value in every iteration of a loop.
+ * When the instance is remote each such read is a GET; hoisting the read
+ * out of the loop replaces them with a single GET before the loop.
+ */
+static void computeWriteOnceFields() {
+  writeOnceFields.clear();
+
+  if(fNoloopInvariantCodeMotion == false && fLoopInvariantRemoteHoist) {
+    collectWriteOnceFields(writeOnceFields);
+  }
+}
+
+
 /*
  * The basic algorithm for loop invariant code motion is as follows:
  * First figure out where the loops actually are. To do this the dominators need 
@@ -1115,6 +1181,8 @@ void loopInvariantCodeMotion(void) {
   
   startTimer(overallTimer);
   long numLoops = 0;
+
+  computeWriteOnceFields();
     
   //TODO use stl routine here
   forv_Vec(FnSymbol, fn, gFnSymbols) {
@@ -24,6 +24,10 @@
 //  the handler (rather than creating a new task).
 //
 
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
 #include <vector>
 #include "stlUtil.h"
 #include "astutil.h"
@@ -403,47 +407,93 @@ inLocalBlock(CallExpr *call) {
   return false;
 }
 
-static int
-markFastSafeFn(FnSymbol *fn, int recurse, Vec<FnSymbol*> *visited) {
+//
+// The summary of a function, computed once for the whole program.
+//
+// Each function is classified from the classifications of the primitives
+// it uses and of the functions it calls, so a chain of calls is fast if
+// every function along it is.  A fast function must also do a bounded
+// amount of work: it may not be recursive, and its longest chain of calls
+// may be at most --optimize-on-clause-limit deep.
+//
+// If the function is not fast, 'reason' says why, for
+// --report-optimized-on.  'call' is the call in this function that it
+// applies to, and 'callee' the function called there, if the reason was
+// found in that function.
+//
+struct FastOnSummary {
+  int         is;
+  int         depth;
+  const char* reason;
+  CallExpr*   call;
+  FnSymbol*   callee;
+};
 
-  // First, handle functions we've already visited.
-  if (visited->in(fn)) {
-    if (fn->hasFlag(FLAG_FAST_ON))
-      return FAST_AND_LOCAL;
-    if (fn->hasFlag(FLAG_LOCAL_FN))
-      return LOCAL_NOT_FAST;
-    return NOT_FAST_NOT_LOCAL;
-  }
+static std::map<FnSymbol*, FastOnSummary> summaries;
+
+static FastOnSummary
+makeSummary(int is, const char* reason, CallExpr* call, FnSymbol* callee) {
+  FastOnSummary summary;
+
+  summary.is     = is;
+  summary.depth  = 0;
+  summary.reason = reason;
+  summary.call   = call;
+  summary.callee = callee;
+
+  return summary;
+}
+
+static FastOnSummary
+summarizeFn(FnSymbol* fn, std::set<FnSymbol*>& inProgress) {
 
-  // Now, add fn to the set of visited functions,
-  // since we will categorize it now.
-  visited->add_exclusive(fn);
+  // First, handle functions we've already summarized.
+  std::map<FnSymbol*, FastOnSummary>::iterator it = summaries.find(fn);
+  if (it != summaries.end())
+    return it->second;
+
+  // A function that is still being summarized has been called recursively.
+  // It is not recorded, since its callers' summaries will say so.
+  if (inProgress.count(fn))
+    return makeSummary(NOT_FAST_NOT_LOCAL, "a recursive call", NULL, NULL);
 
   // Next, classify extern functions
   if (fn->hasFlag(FLAG_EXTERN)) {
+    FastOnSummary summary;
+
     if (fn->hasFlag(FLAG_FAST_ON_SAFE_EXTERN)) {
       // Make sure the FAST_ON and LOCAL_FN flags are set.
       fn->addFlag(FLAG_FAST_ON);
       fn->addFlag(FLAG_LOCAL_FN);
-      return FAST_AND_LOCAL;
+      summary = makeSummary(FAST_AND_LOCAL, NULL, NULL, NULL);
     } else if(fn->hasFlag(FLAG_LOCAL_FN)) {
-      return LOCAL_NOT_FAST;
+      summary = makeSummary(LOCAL_NOT_FAST,
+                            "an extern function not known to be fast",
+                            NULL, NULL);
     } else {
       // Other extern functions are not fast or local.
-      return NOT_FAST_NOT_LOCAL;
+      summary = makeSummary(NOT_FAST_NOT_LOCAL,
+                            "an extern function not known to be local",
+                            NULL, NULL);
     }
+
+    summaries[fn] = summary;
+    return summary;
   }
 
+  inProgress.insert(fn);
+
   // Next, go through function bodies.
-  // We will set maybefast=false if we see something in the function
+  // The summary becomes LOCAL_NOT_FAST if we see something in the function
   //  that is local but not suitable for a signal handler
   //  (mostly allocation or locking).
-  // We will return NOT_FAST_NOT_LOCAL immediately if we see something
+  // It becomes NOT_FAST_NOT_LOCAL, and we stop, if we see something
   // in the function that is not local.
-  bool maybefast = true;
+  FastOnSummary summary = makeSummary(FAST_AND_LOCAL, NULL, NULL, NULL);
 
   if (fn->hasFlag(FLAG_NON_BLOCKING))
-    maybefast = false;
+    summary = makeSummary(LOCAL_NOT_FAST, "a non-blocking task function",
+                          NULL, NULL);
 
   std::vector<CallExpr*> calls;
 
@@ -456,53 +506,115 @@ markFastSafeFn(FnSymbol *fn, int recurse, Vec<FnSymbol*> *visited) {
       int is = classifyPrimitive(call, inLocal);
       if (!isLocal(is)) {
         // FAST_NOT_LOCAL or NOT_FAST_NOT_LOCAL
-        return NOT_FAST_NOT_LOCAL;
+        summary = makeSummary(NOT_FAST_NOT_LOCAL, "communication", call, NULL);
+        break;
       }
       // is == FAST_AND_LOCAL requires no action
-      if (is == LOCAL_NOT_FAST)
-        maybefast = false;
+      if (is == LOCAL_NOT_FAST && summary.is == FAST_AND_LOCAL)
+        summary = makeSummary(LOCAL_NOT_FAST,
+                              "a primitive that may allocate or block",
+                              call, NULL);
+    } else if (!call->isResolved()) {
+      // No unresolved function calls allowed
+      summary = makeSummary(NOT_FAST_NOT_LOCAL, "an unresolved call",
+                            call, NULL);
+      break;
     } else {
-      if (recurse<=0 || !call->isResolved()) {
-        // didn't resolve or past too much recursion.
-        // No function calls allowed
-        return NOT_FAST_NOT_LOCAL;
-      } else {
-        // Handle nested 'on' statements
-        if (call->isResolved()->hasFlag(FLAG_ON_BLOCK)) {
-          if (inLocal)
-            maybefast = false;
-          else
-            return NOT_FAST_NOT_LOCAL;
+      FnSymbol* callee = call->isResolved();
+
+      // Handle nested 'on' statements
+      if (callee->hasFlag(FLAG_ON_BLOCK)) {
+        if (!inLocal) {
+          summary = makeSummary(NOT_FAST_NOT_LOCAL, "a nested on statement",
+                                call, NULL);
+          break;
         }
+        if (summary.is == FAST_AND_LOCAL)
+          summary = makeSummary(LOCAL_NOT_FAST, "a nested on statement",
+                                call, NULL);
+      }
 
-        // is the call to a fast/local function?
-        int is = markFastSafeFn(call->isResolved(), recurse-1, visited);
-
-        // Remove NOT_LOCAL parts if it's in a local block
-        is = setLocal(is, inLocal);
+      // is the call to a fast/local function?
+      FastOnSummary calleeSummary = summarizeFn(callee, inProgress);
 
-        if (!isLocal(is))
-          return NOT_FAST_NOT_LOCAL;
+      // Remove NOT_LOCAL parts if it's in a local block
+      int is = setLocal(calleeSummary.is, inLocal);
 
-        if (is == LOCAL_NOT_FAST)
-          maybefast = false;
-        // otherwise, possibly still fast.
+      if (!isLocal(is)) {
+        summary = makeSummary(NOT_FAST_NOT_LOCAL, calleeSummary.reason,
+                              call, callee);
+        break;
       }
+
+      if (is == LOCAL_NOT_FAST && summary.is == FAST_AND_LOCAL)
+        summary = makeSummary(LOCAL_NOT_FAST, calleeSummary.reason,
+                              call, callee);
+      // otherwise, possibly still fast.
+
+      summary.depth = std::max(summary.depth, calleeSummary.depth + 1);
     }
   }
 
-  // At this point we've considered all of the function body
-  // so if maybefast is still true, we can consider this function fast.
+  // A fast function must do a bounded amount of work
+  if (summary.is == FAST_AND_LOCAL &&
+      summary.depth > optimize_on_clause_limit)
+    summary = makeSummary(LOCAL_NOT_FAST,
+                          "a chain of calls deeper than "
+                          "--optimize-on-clause-limit",
+                          NULL, NULL);
 
-  // We only get to this point if the function is local
-  // (otherwise we would return above)
-  fn->addFlag(FLAG_LOCAL_FN);
-  if (maybefast) {
+  inProgress.erase(fn);
+
+  // At this point we've considered all of the function body
+  // so if the summary is still fast, we can consider this function fast.
+  if (isLocal(summary.is))
+    fn->addFlag(FLAG_LOCAL_FN);
+  if (summary.is == FAST_AND_LOCAL)
     fn->addFlag(FLAG_FAST_ON);
-    return FAST_AND_LOCAL;
-  } else {
-    return LOCAL_NOT_FAST;
+
+  summaries[fn] = summary;
+  return summary;
+}
+
+static int
+markFastSafeFn(FnSymbol* fn) {
+  std::set<FnSymbol*> inProgress;
+
+  return summarizeFn(fn, inProgress).is;
+}
+
+//
+// Why an on statement was not optimized: the reason, where it was found,
+// and the calls that lead there.
+//
+static std::string
+describeNotFast(FnSymbol* fn) {
+  std::string         calls;
+  std::set<FnSymbol*> seen;
+  FastOnSummary       summary = summaries[fn];
+  CallExpr*           where   = summary.call;
+
+  while (summary.callee != NULL && seen.insert(summary.callee).second) {
+    if (calls.empty())
+      calls = " via ";
+    else
+      calls += ", ";
+    calls += summary.callee->name;
+
+    summary = summaries[summary.callee];
+    if (summary.call != NULL)
+      where = summary.call;
   }
+
+  std::string retval = summary.reason ? summary.reason : "unknown";
+
+  if (where != NULL) {
+    char loc[256];
+    snprintf(loc, sizeof(loc), " (%s:%d)", where->fname(), where->linenum());
+    retval += loc;
+  }
+
+  return retval + calls;
 }
 
 // Removes PRIM_START_RMEM_FENCE and PRIM_FINISH_RMEM_FENCE
@@ -562,10 +674,10 @@ optimizeOnClauses(void) {
 
   compute_call_sites();
 
-  forv_Vec(FnSymbol, fn, gFnSymbols) {
-    Vec<FnSymbol*> visited;
+  summaries.clear();
 
-    int is = markFastSafeFn(fn, optimize_on_clause_limit, &visited);
+  forv_Vec(FnSymbol, fn, gFnSymbols) {
+    int is = markFastSafeFn(fn);
 
     bool fastFork = isFast(is);
     bool removeRmemFences = isLocal(is);
@@ -607,5 +719,19 @@ optimizeOnClauses(void) {
         if (developer) printf("(id %i)\n", fn->id);
       }
     }
+
+    if (!fastFork && fn->hasFlag(FLAG_ON_BLOCK) && fReportOptimizedOn) {
+      ModuleSymbol *mod = toModuleSymbol(fn->defPoint->parentSymbol);
+      INT_ASSERT(mod);
+      if (developer ||
+          ((mod->modTag != MOD_INTERNAL) && (mod->modTag != MOD_STANDARD))) {
+        printf("Did not optimize on clause (%s) in module %s (%s:%d): %s\n",
+               fn->cname, mod->name, fn->fname(), fn->linenum(),
+               describeNotFast(fn).c_str());
+        if (developer) printf("(id %i)\n", fn->id);
+      }
+    }
   }
+
+  summaries.clear();
 }
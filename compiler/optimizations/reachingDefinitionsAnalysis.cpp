@@ -24,6 +24,7 @@
 #include "astutil.h"
 #include "bb.h"
 #include "bitVec.h"
+#include "compilerTrace.h"
 #include "expr.h"
 #include "stlUtil.h"
 #include "stmt.h"
@@ -36,7 +37,8 @@ reachingDefinitionsAnalysis(FnSymbol* fn,
                             Vec<SymExpr*>& useSet,
                             Vec<SymExpr*>& defSet,
                             std::vector<BitVec*>& IN) {
-  Vec<Symbol*> locals;
+  TraceRegion      region("reachingDefinitionsAnalysis", fn->name);
+  Vec<Symbol*>     locals;
   Map<Symbol*,int> localMap;
 
   BasicBlock::buildLocalsVectorMap(fn, locals, localMap);
@@ -63,6 +65,7 @@ reachingDefinitionsAnalysis(FnSymbol* fn,
     localDefs[i] = sum;
     sum += nextSum;
   }
+  std::vector<int> localDefsStart(localDefs);
   forv_Vec(SymExpr, se, defSet) {
     if (se) {
       int i = localDefs[localMap.get(se->symbol())]++;
@@ -94,9 +97,17 @@ reachingDefinitionsAnalysis(FnSymbol* fn,
         }
       }
     }
-    for (int i = 0; i < defs.n; i++) {
-      if (bbDefSet.set_in(defs.v[i]->symbol()))
-        kill->set(i);
+    //
+    // the defs of a local are adjacent, running from its entry in
+    // localDefsStart up to its entry in localDefs, so only visit the defs
+    // of the locals defined in this block
+    //
+    forv_Vec(Symbol, sym, bbDefSet) {
+      if (sym) {
+        int id = localMap.get(sym);
+        for (int i = localDefsStart[id]; i < localDefs[id]; i++)
+          kill->set(i);
+      }
     }
     KILL.push_back(kill);
     GEN.push_back(gen);
@@ -20,6 +20,8 @@
 #include "optimizations.h"
 
 #include "astutil.h"
+#include "driver.h"
+#include "resolution.h"
 #include "stringutil.h"
 #include "stlUtil.h"
 #include "expr.h"
@@ -310,27 +312,43 @@ static bool canForwardValue(Map<Symbol*, Vec<SymExpr*>*>& defMap,
 
 static bool isSufficientlyConst(ArgSymbol* arg);
 
-static void updateTaskArg(Map<Symbol*, Vec<SymExpr*>*>& useMap,
+static int  updateTaskArg(Map<Symbol*, Vec<SymExpr*>*>& useMap,
                           FnSymbol*                     fn,
                           ArgSymbol*                    arg);
 
+static int  forwardFieldReads(FnSymbol*          fn,
+                              std::set<Symbol*>& writeOnceFields);
+
+static void reportRemoteValueForwarding(FnSymbol* fn, int numReads);
+
 static void updateTaskFunctions(Map<Symbol*, Vec<SymExpr*>*>& defMap,
                                 Map<Symbol*, Vec<SymExpr*>*>& useMap) {
-  Vec<FnSymbol*> syncSet;
+  Vec<FnSymbol*>    syncSet;
+  std::set<Symbol*> writeOnceFields;
 
   buildSyncAccessFunctionSet(syncSet);
 
+  collectWriteOnceFields(writeOnceFields);
+
   forv_Vec(FnSymbol, fn, gFnSymbols) {
     if (fn->hasFlag(FLAG_ON) == true) {
+      int numReads = 0;
+
       // Would need to flatten them if they are not already.
       INT_ASSERT(isGlobal(fn));
 
       // For each reference arg that is safe to dereference
       for_formals(arg, fn) {
         if (canForwardValue(defMap, useMap, syncSet, fn, arg)) {
-          updateTaskArg(useMap, fn, arg);
+          numReads += updateTaskArg(useMap, fn, arg);
         }
       }
+
+      numReads += forwardFieldReads(fn, writeOnceFields);
+
+      if (fReportRemoteValueForwarding == true && numReads > 0) {
+        reportRemoteValueForwarding(fn, numReads);
+      }
     }
   }
 }
@@ -439,9 +457,15 @@ static bool isSufficientlyConst(ArgSymbol* arg) {
   return retval;
 }
 
-static void updateTaskArg(Map<Symbol*, Vec<SymExpr*>*>& useMap,
-                          FnSymbol*                     fn,
-                          ArgSymbol*                    arg) {
+//
+// Returns the number of uses of the arg, each of which was a read through
+// a (possibly remote) reference.
+//
+static int updateTaskArg(Map<Symbol*, Vec<SymExpr*>*>& useMap,
+                         FnSymbol*                     fn,
+                         ArgSymbol*                    arg) {
+  int retval = 0;
+
   // Dereference the arg type.
   Type* prevArgType = arg->type;
 
@@ -480,6 +504,8 @@ static void updateTaskArg(Map<Symbol*, Vec<SymExpr*>*>& useMap,
   for_uses(use, useMap, arg) {
     SET_LINENO(use);
 
+    retval++;
+
     CallExpr* call = toCallExpr(use->parentExpr);
     if (!call) continue;
 
@@ -508,6 +534,358 @@ static void updateTaskArg(Map<Symbol*, Vec<SymExpr*>*>& useMap,
       use->replace(new SymExpr(reref));
     }
   }
+
+  return retval;
+}
+
+/************************************* | **************************************
+*                                                                             *
+* Forward the fields of a class instance that an on-body reads.               *
+*                                                                             *
+* When the on-body reads a field of a class argument, and the field is only   *
+* written while an instance is being constructed, the field is read at the    *
+* call site instead and passed as an extra value argument.  The value then    *
+* travels in the arg bundle of the on-statement rather than being fetched     *
+* with a GET from inside the remote task.                                     *
+*                                                                             *
+* A read is only moved if it executes unconditionally, i.e. outside of any    *
+* conditional or loop in the on-body.  An instance is not forwarded if it,    *
+* or anything computed from it, is the target of the on-statement: "on obj"   *
+* is meant to make reads of obj local.                                        *
+*                                                                             *
+************************************** | *************************************/
+
+static bool     isForwardableInstance(FnSymbol*             fn,
+                                      ArgSymbol*            arg,
+                                      std::vector<Symbol*>& instances);
+
+static bool     onTargetUses(CallExpr* call, Symbol* sym);
+
+static Symbol*  fieldRead(SymExpr* se);
+
+static bool     isUnconditional(FnSymbol* fn, Expr* stmt);
+
+static Symbol*  accessedField(FnSymbol* accessor);
+
+static bool     isForwardableFieldType(Symbol* field);
+
+static int      forwardField(FnSymbol*               fn,
+                             ArgSymbol*              arg,
+                             Symbol*                 field,
+                             std::vector<CallExpr*>& reads);
+
+static int forwardFieldReads(FnSymbol*          fn,
+                             std::set<Symbol*>& writeOnceFields) {
+  std::vector<ArgSymbol*> classArgs;
+  int                     retval = 0;
+
+  for_formals(arg, fn) {
+    if (isClass(arg->type) == true         &&
+        arg->intent        != INTENT_REF   &&
+        arg->intent        != INTENT_INOUT &&
+        arg->intent        != INTENT_OUT) {
+      classArgs.push_back(arg);
+    }
+  }
+
+  for_vector(ArgSymbol, arg, classArgs) {
+    std::vector<Symbol*> instances;
+
+    if (isForwardableInstance(fn, arg, instances) == true) {
+      std::map<Symbol*, std::vector<CallExpr*> > reads;
+
+      for_vector(Symbol, instance, instances) {
+        for_SymbolSymExprs(se, instance) {
+          if (Symbol* field = fieldRead(se)) {
+            CallExpr* move = toCallExpr(se->parentExpr->parentExpr);
+
+            if (isUnconditional(fn, move)     == true &&
+                writeOnceFields.count(field)  == 1    &&
+                isForwardableFieldType(field) == true) {
+              reads[field].push_back(toCallExpr(se->parentExpr));
+            }
+          }
+        }
+      }
+
+      for (std::map<Symbol*, std::vector<CallExpr*> >::iterator it =
+             reads.begin();
+           it != reads.end();
+           ++it) {
+        retval += forwardField(fn, arg, it->first, it->second);
+      }
+    }
+  }
+
+  return retval;
+}
+
+//
+// The instance must not change during the on-body.  Collects the arg and
+// the temps that hold it, e.g. the re-reference temps that updateTaskArg()
+// introduced or the receiver temps of accessor calls.
+//
+static bool isForwardableInstance(FnSymbol*             fn,
+                                  ArgSymbol*            arg,
+                                  std::vector<Symbol*>& instances) {
+  bool retval = true;
+
+  instances.push_back(arg);
+
+  for_SymbolSymExprs(se, arg) {
+    CallExpr* parent = toCallExpr(se->parentExpr);
+
+    if (parent != NULL && parent->isPrimitive(PRIM_ADDR_OF)) {
+      parent = toCallExpr(parent->parentExpr);
+    }
+
+    if (isDefAndOrUse(se) & 1) {
+      retval = false;
+
+    } else if (parent                        != NULL &&
+               parent->isPrimitive(PRIM_MOVE) == true &&
+               parent->get(1)                != se) {
+      Symbol* tmp     = toSymExpr(parent->get(1))->symbol();
+      int     numDefs = 0;
+
+      for_SymbolSymExprs(tmpSe, tmp) {
+        if (isDefAndOrUse(tmpSe) & 1) {
+          numDefs++;
+        }
+      }
+
+      if (tmp->hasFlag(FLAG_TEMP) == true && numDefs == 1) {
+        instances.push_back(tmp);
+      }
+    }
+  }
+
+  //
+  // The actual is the temp that holds the value for the on-body; the
+  // caller may not change it while the on-body runs.
+  //
+  forv_Vec(CallExpr, call, *fn->calledBy) {
+    SymExpr* actual = toSymExpr(formal_to_actual(call, arg));
+
+    if (actual                               == NULL  ||
+        actual->isRef()                      == true  ||
+        actual->symbol()->hasFlag(FLAG_TEMP) == false ||
+        onTargetUses(call, actual->symbol()) == true) {
+      retval = false;
+    }
+  }
+
+  return retval;
+}
+
+//
+// Is the value of sym used to compute the locale that the on-function is run
+// on?  Both are followed through the temps they are computed from.
+//
+static void collectSources(Symbol* sym, std::set<Symbol*>& sources);
+
+static bool onTargetUses(CallExpr* call, Symbol* sym) {
+  bool retval = false;
+
+  if (SymExpr* target = toSymExpr(call->get(1))) {
+    std::set<Symbol*> targetSources;
+    std::set<Symbol*> symSources;
+
+    collectSources(target->symbol(), targetSources);
+    collectSources(sym,              symSources);
+
+    for (std::set<Symbol*>::iterator it = symSources.begin();
+         it != symSources.end();
+         ++it) {
+      if (targetSources.count(*it) == 1) {
+        retval = true;
+      }
+    }
+
+  } else {
+    retval = true;
+  }
+
+  return retval;
+}
+
+static void collectSources(Symbol* sym, std::set<Symbol*>& sources) {
+  std::vector<Symbol*> worklist;
+
+  worklist.push_back(sym);
+
+  while (worklist.size() > 0) {
+    Symbol* cur = worklist.back();
+
+    worklist.pop_back();
+
+    if (sources.insert(cur).second == true &&
+        isVarSymbol(cur)           == true &&
+        cur->hasFlag(FLAG_TEMP)    == true) {
+      for_SymbolSymExprs(se, cur) {
+        if (isDefAndOrUse(se) & 1) {
+          std::vector<SymExpr*> symExprs;
+
+          collectSymExprs(se->getStmtExpr(), symExprs);
+
+          for_vector(SymExpr, other, symExprs) {
+            if (isFnSymbol(other->symbol()) == false) {
+              worklist.push_back(other->symbol());
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+//
+// Returns the field if se is the instance of a field read of the form
+//
+//   move tmp, GET_MEMBER_VALUE(se, field)
+//   move tmp, accessor(se)
+//
+static Symbol* fieldRead(SymExpr* se) {
+  CallExpr* read   = toCallExpr(se->parentExpr);
+  CallExpr* move   = (read) ? toCallExpr(read->parentExpr) : NULL;
+  Symbol*   retval = NULL;
+
+  if (read                         != NULL &&
+      read->get(1)                 == se   &&
+      move                         != NULL &&
+      move->isPrimitive(PRIM_MOVE) == true &&
+      move->get(2)                 == read) {
+    if (read->isPrimitive(PRIM_GET_MEMBER_VALUE) == true) {
+      retval = toSymExpr(read->get(2))->symbol();
+
+    } else if (FnSymbol* accessor = read->isResolved()) {
+      if (read->numActuals() == 1 && move->get(1)->isRef() == true) {
+        retval = accessedField(accessor);
+      }
+    }
+  }
+
+  return retval;
+}
+
+//
+// Is stmt in a plain block nest directly under the body of fn?
+//
+static bool isUnconditional(FnSymbol* fn, Expr* stmt) {
+  Expr* expr   = stmt->parentExpr;
+  bool  retval = true;
+
+  while (retval == true && expr != fn->body) {
+    BlockStmt* block = toBlockStmt(expr);
+
+    if (block                 == NULL  ||
+        block->isLoopStmt()   == true  ||
+        block->blockInfoGet() != NULL) {
+      retval = false;
+    } else {
+      expr = expr->parentExpr;
+    }
+  }
+
+  return retval;
+}
+
+//
+// The field returned by a compiler-generated accessor, whose body is
+//
+//   move call_tmp, GET_MEMBER(this, field)
+//   move ret, call_tmp
+//   return ret
+//
+static Symbol* accessedField(FnSymbol* accessor) {
+  Symbol* retval = NULL;
+
+  if (accessor->hasFlag(FLAG_FIELD_ACCESSOR) == true &&
+      accessor->numFormals()                 == 1    &&
+      accessor->body->body.length            == 5) {
+    std::vector<CallExpr*> calls;
+
+    collectCallExprs(accessor->body, calls);
+
+    for_vector(CallExpr, call, calls) {
+      if (call->isPrimitive(PRIM_GET_MEMBER)  == true &&
+          toSymExpr(call->get(1))->symbol() == accessor->getFormal(1)) {
+        retval = toSymExpr(call->get(2))->symbol();
+      }
+    }
+  }
+
+  return retval;
+}
+
+static bool isForwardableFieldType(Symbol* field) {
+  Type* type   = field->type;
+  bool  retval = false;
+
+  if (field->isRef()       == true  ||
+      type                 == dtVoid ||
+      isSyncType(type)     == true  ||
+      isSingleType(type)   == true  ||
+      isAtomicType(type)   == true) {
+    retval = false;
+
+  } else {
+    retval = isClass(type) || isRecordWrappedType(type) || isPOD(type);
+  }
+
+  return retval;
+}
+
+static int forwardField(FnSymbol*               fn,
+                        ArgSymbol*              arg,
+                        Symbol*                 field,
+                        std::vector<CallExpr*>& reads) {
+  SET_LINENO(fn);
+
+  ArgSymbol* fieldArg = new ArgSymbol(INTENT_CONST_IN,
+                                      astr("rvf_", field->name),
+                                      field->type);
+
+  forv_Vec(CallExpr, call, *fn->calledBy) {
+    SymExpr*   actual = toSymExpr(formal_to_actual(call, arg));
+    VarSymbol* tmp    = newTemp("rvfFieldTmp", field->type);
+    CallExpr*  get    = new CallExpr(PRIM_GET_MEMBER_VALUE,
+                                     actual->symbol(),
+                                     field);
+
+    SET_LINENO(call);
+
+    call->insertBefore(new DefExpr(tmp));
+    call->insertBefore(new CallExpr(PRIM_MOVE, tmp, get));
+
+    call->insertAtTail(tmp);
+  }
+
+  fn->insertFormalAtTail(fieldArg);
+
+  // An accessor returns a reference to the field
+  for_vector(CallExpr, read, reads) {
+    if (read->isPrimitive(PRIM_GET_MEMBER_VALUE) == true) {
+      read->replace(new SymExpr(fieldArg));
+    } else {
+      read->replace(new CallExpr(PRIM_ADDR_OF, fieldArg));
+    }
+  }
+
+  return (int) reads.size();
+}
+
+static void reportRemoteValueForwarding(FnSymbol* fn, int numReads) {
+  ModuleSymbol* mod = fn->getModule();
+
+  if (developer ||
+      (mod->modTag != MOD_INTERNAL && mod->modTag != MOD_STANDARD)) {
+    printf("Remote value forwarding made %d reads local in on clause "
+           "(%s) in module %s (%s:%d)\n",
+           numReads, fn->cname, mod->name, fn->fname(), fn->linenum());
+
+    if (developer) printf("(id %i)\n", fn->id);
+  }
 }
 
 
@@ -22,16 +22,25 @@
 //
 // This pass implements scalar replacement of aggregates.
 //
+// Small records are also replaced across calls: a record formal is
+// replaced by a formal for each of its fields, and a record returned by
+// value is returned through a ref formal for each of its fields.  The
+// records on both sides of the call are then local and can be replaced
+// as usual, rather than being stored to memory to pass their address.
+//
 
 #include "astutil.h"
 #include "expr.h"
 #include "optimizations.h"
 #include "passes.h"
+#include "stlUtil.h"
 #include "stmt.h"
 #include "stringutil.h"
 #include "symbol.h"
 #include "view.h"
 
+#include <vector>
+
 static const bool debugScalarReplacement = false;
 
 // statistics
@@ -39,6 +48,11 @@ static int srClass = 0;
 static int srClassReplaced = 0;
 static int srRecord = 0;
 static int srRecordReplaced = 0;
+static int srArg = 0;
+static int srArgReplaced = 0;
+static int srReturn = 0;
+static int srReturnReplaced = 0;
+static int srSpillsRemoved = 0;
 
 //
 // typeVec - a vector of candidate types for scalar replacement
@@ -508,6 +522,350 @@ scalarReplaceRecord(AggregateType* ct, Symbol* sym) {
   return true;
 }
 
+//
+// Can a record of this type be passed as its fields?  Its fields must be
+// scalars, so that each can be passed by value.
+//
+static bool
+isFlattenableType(Type* type) {
+  AggregateType* ct = toAggregateType(type);
+
+  if (!ct || !isRecord(ct) || !typeVarMap.get(ct))
+    return false;
+
+  for_fields(field, ct) {
+    if (field->type == dtVoid ||
+        isRecord(field->type) ||
+        isUnion(field->type) ||
+        field->isRef() ||
+        field->type->symbol->hasFlag(FLAG_REF))
+      return false;
+  }
+  return true;
+}
+
+//
+// Can the signature of fn be changed?  Every reference to it must be a
+// direct call, and it must not be called through the function table.
+//
+static bool
+isFlattenableFn(FnSymbol* fn) {
+  if (!fn->inTree() ||
+      fn == chpl_gen_main ||
+      fn->hasFlag(FLAG_EXTERN) ||
+      fn->hasFlag(FLAG_EXPORT) ||
+      fn->hasFlag(FLAG_VIRTUAL) ||
+      fn->hasFlag(FLAG_NO_CODEGEN) ||
+      fn->hasFlag(FLAG_MODULE_INIT) ||
+      fn->hasFlag(FLAG_AUTO_COPY_FN) ||
+      fn->hasFlag(FLAG_INIT_COPY_FN) ||
+      fn->hasFlag(FLAG_AUTO_DESTROY_FN) ||
+      fn->hasFlag(FLAG_CONSTRUCTOR) ||
+      fn->hasFlag(FLAG_BEGIN_BLOCK) ||
+      fn->hasFlag(FLAG_ON_BLOCK) ||
+      fn->hasFlag(FLAG_COBEGIN_OR_COFORALL_BLOCK) ||
+      isTaskFun(fn) ||
+      virtualChildrenMap.get(fn) ||
+      virtualRootsMap.get(fn) ||
+      ftableMap.count(fn))
+    return false;
+
+  for_SymbolSymExprs(se, fn) {
+    CallExpr* call = toCallExpr(se->parentExpr);
+    if (!call || call->baseExpr != se)
+      return false;
+  }
+  return true;
+}
+
+static SymExpr*
+actualForFormal(CallExpr* call, ArgSymbol* formal) {
+  for_formals_actuals(arg, actual, call) {
+    if (arg == formal)
+      return toSymExpr(actual);
+  }
+  return NULL;
+}
+
+//
+// Is se, a use of a record formal of fn or of a ref to it, only a read?
+// It may be a field read, a copy, or a const actual, in which case the
+// record is rebuilt from its fields; fn must then not return a reference,
+// which could be to the record.
+//
+static bool
+isRecordRead(FnSymbol* fn, SymExpr* se, Type* type) {
+  Expr* use = se;
+  CallExpr* call = toCallExpr(se->parentExpr);
+  if (call && call->isPrimitive(PRIM_DEREF)) {
+    use = call;
+    call = toCallExpr(call->parentExpr);
+  }
+  if (!call)
+    return false;
+  if (call->isPrimitive(PRIM_GET_MEMBER_VALUE) && call->get(1) == se)
+    return true;
+
+  // a ref to the record, whose uses must be reads
+  if (call->isPrimitive(PRIM_ADDR_OF) ||
+      call->isPrimitive(PRIM_SET_REFERENCE)) {
+    CallExpr* move = toCallExpr(call->parentExpr);
+    if (!move || !move->isPrimitive(PRIM_MOVE) || move->get(2) != call)
+      return false;
+    SymExpr* lhs = toSymExpr(move->get(1));
+    if (!isVarSymbol(lhs->symbol()) || !lhs->symbol()->isRef())
+      return false;
+    for_SymbolSymExprs(rse, lhs->symbol()) {
+      if (rse != lhs && !isRecordRead(fn, rse, type))
+        return false;
+    }
+    return true;
+  }
+
+  if (use == se && call->isResolved()) {
+    ArgSymbol* arg = actual_to_formal(se);
+    return fn->retTag == RET_VALUE &&
+           (arg->intent == INTENT_CONST_REF || arg->intent == INTENT_CONST_IN);
+  }
+
+  // a copy of the record
+  return call->isPrimitive(PRIM_MOVE) &&
+         call->get(2) == use &&
+         !call->get(1)->isRef() &&
+         call->get(1)->getValType() == type;
+}
+
+//
+// A record formal can be replaced by its fields if fn only reads it, and
+// nothing can change the actual during the call: the actual is a local
+// that is not passed by ref in the same call.
+//
+static bool
+canFlattenFormal(FnSymbol* fn, ArgSymbol* formal) {
+  if (formal->hasFlag(FLAG_ARG_THIS) ||
+      formal->hasFlag(FLAG_RETARG) ||
+      (formal->intent != INTENT_CONST_REF &&
+       formal->intent != INTENT_CONST_IN) ||
+      !isFlattenableType(formal->type))
+    return false;
+
+  for_SymbolSymExprs(se, formal) {
+    if (!isRecordRead(fn, se, formal->type))
+      return false;
+  }
+
+  for_SymbolSymExprs(fse, fn) {
+    CallExpr* call = toCallExpr(fse->parentExpr);
+    SymExpr* actual = actualForFormal(call, formal);
+    if (!actual)
+      return false;
+    Symbol* sym = actual->symbol();
+    if (!isVarSymbol(sym) ||
+        isGlobal(sym) ||
+        sym->isRef() ||
+        sym->type != formal->type)
+      return false;
+    for_actuals(other, call) {
+      SymExpr* se = toSymExpr(other);
+      if (other != actual &&
+          (!se ||
+           se->symbol() == sym ||
+           (se->isRef() && se->getValType() == sym->type)))
+        return false;
+    }
+  }
+  return true;
+}
+
+static void
+flattenFormal(FnSymbol* fn, ArgSymbol* formal) {
+  AggregateType* ct = toAggregateType(formal->type);
+  SET_LINENO(formal);
+
+  //
+  // pass the fields of the actuals
+  //
+  for_SymbolSymExprs(fse, fn) {
+    CallExpr* call = toCallExpr(fse->parentExpr);
+    SymExpr* actual = actualForFormal(call, formal);
+    Expr* stmt = call->getStmtExpr();
+    SET_LINENO(call);
+    for_fields(field, ct) {
+      VarSymbol* tmp = newTemp(astr(actual->symbol()->name, "_", field->name),
+                               field->type);
+      stmt->insertBefore(new DefExpr(tmp));
+      stmt->insertBefore(new CallExpr(PRIM_MOVE, tmp,
+                           new CallExpr(PRIM_GET_MEMBER_VALUE,
+                                        actual->symbol(), field)));
+      actual->insertBefore(new SymExpr(tmp));
+    }
+    actual->remove();
+    if (fReportScalarReplace) srSpillsRemoved++;
+  }
+
+  //
+  // rebuild the record from the field formals
+  //
+  VarSymbol* local = newTemp(formal->name, ct);
+  Expr* last = new DefExpr(local);
+  fn->insertAtHead(last);
+  for_fields(field, ct) {
+    ArgSymbol* arg = new ArgSymbol(INTENT_CONST_IN,
+                                   astr(formal->name, "_", field->name),
+                                   field->type);
+    formal->defPoint->insertBefore(new DefExpr(arg));
+    CallExpr* set = new CallExpr(PRIM_SET_MEMBER, local, field, arg);
+    last->insertAfter(set);
+    last = set;
+  }
+
+  for_SymbolSymExprs(se, formal) {
+    CallExpr* call = toCallExpr(se->parentExpr);
+    if (call && call->isPrimitive(PRIM_DEREF))
+      call->replace(new SymExpr(local));
+    else
+      se->setSymbol(local);
+  }
+  formal->defPoint->remove();
+}
+
+//
+// A record returned by value can be returned through a ref formal for
+// each of its fields if the result of every call is moved to a record.
+//
+static bool
+canFlattenReturn(FnSymbol* fn) {
+  if (fn->hasFlag(FLAG_FN_RETARG) ||
+      fn->retTag != RET_VALUE ||
+      !isFlattenableType(fn->retType))
+    return false;
+
+  for_fields(field, toAggregateType(fn->retType)) {
+    if (!field->type->refType)
+      return false;
+  }
+
+  CallExpr* ret = toCallExpr(fn->body->body.tail);
+  if (!ret || !ret->isPrimitive(PRIM_RETURN) ||
+      !isSymExpr(ret->get(1)) ||
+      ret->get(1)->isRef() ||
+      ret->get(1)->typeInfo() != fn->retType)
+    return false;
+
+  for_SymbolSymExprs(se, fn) {
+    CallExpr* call = toCallExpr(se->parentExpr);
+    CallExpr* move = toCallExpr(call->parentExpr);
+    if (call->getStmtExpr() == call)
+      continue;
+    if (!move || !move->isPrimitive(PRIM_MOVE) ||
+        move->get(2) != call ||
+        move->get(1)->isRef() ||
+        move->get(1)->typeInfo() != fn->retType)
+      return false;
+  }
+  return true;
+}
+
+static void
+flattenReturn(FnSymbol* fn) {
+  AggregateType* ct = toAggregateType(fn->retType);
+  Symbol* ret = fn->getReturnSymbol();
+  std::vector<CallExpr*> calls;
+  SET_LINENO(fn);
+
+  for_SymbolSymExprs(se, fn) {
+    calls.push_back(toCallExpr(se->parentExpr));
+  }
+
+  for_fields(field, ct) {
+    ArgSymbol* arg = new ArgSymbol(INTENT_REF,
+                                   astr("_ret_", field->name),
+                                   field->type->refType);
+    VarSymbol* tmp = newTemp(astr(ret->name, "_", field->name), field->type);
+    fn->insertFormalAtTail(arg);
+    fn->insertBeforeReturnAfterLabel(new DefExpr(tmp));
+    fn->insertBeforeReturnAfterLabel(
+      new CallExpr(PRIM_MOVE, tmp,
+                   new CallExpr(PRIM_GET_MEMBER_VALUE, ret, field)));
+    fn->insertBeforeReturnAfterLabel(new CallExpr(PRIM_MOVE, arg, tmp));
+  }
+  fn->retType = dtVoid;
+  toCallExpr(fn->body->body.tail)->get(1)->replace(new SymExpr(gVoid));
+
+  for_vector(CallExpr, call, calls) {
+    CallExpr* move = toCallExpr(call->parentExpr);
+    Symbol* lhs = NULL;
+    Expr* last = call;
+    SET_LINENO(call);
+    if (move) {
+      lhs = toSymExpr(move->get(1))->symbol();
+      move->replace(call->remove());
+    }
+    for_fields(field, ct) {
+      VarSymbol* tmp = newTemp(astr("ret_", field->name), field->type);
+      VarSymbol* ref = newTemp(astr("ret_", field->name),
+                               field->type->refType);
+      call->insertBefore(new DefExpr(tmp));
+      call->insertBefore(new DefExpr(ref));
+      call->insertBefore(new CallExpr(PRIM_MOVE, ref,
+                           new CallExpr(PRIM_ADDR_OF, tmp)));
+      call->insertAtTail(ref);
+      if (lhs) {
+        CallExpr* set = new CallExpr(PRIM_SET_MEMBER, lhs, field, tmp);
+        last->insertAfter(set);
+        last = set;
+      }
+    }
+    if (fReportScalarReplace) srSpillsRemoved++;
+  }
+}
+
+//
+// A formal passed on to another function is a local once the caller's
+// formal has been replaced, so repeat until no more formals are replaced.
+//
+static void
+flattenRecordArgsAndReturns() {
+  std::vector<ArgSymbol*> formals;
+
+  forv_Vec(FnSymbol, fn, gFnSymbols) {
+    if (isFlattenableFn(fn)) {
+      for_formals(formal, fn) {
+        if (isFlattenableType(formal->type)) {
+          if (fReportScalarReplace) srArg++;
+          formals.push_back(formal);
+        }
+      }
+    }
+  }
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (size_t i = 0; i < formals.size(); i++) {
+      ArgSymbol* formal = formals[i];
+      FnSymbol* fn = toFnSymbol(formal->defPoint->parentSymbol);
+      if (formal->defPoint->inTree() && canFlattenFormal(fn, formal)) {
+        if (fReportScalarReplace) srArgReplaced++;
+        flattenFormal(fn, formal);
+        changed = true;
+      }
+    }
+  }
+
+  forv_Vec(FnSymbol, fn, gFnSymbols) {
+    if (isFlattenableFn(fn)) {
+      if (isFlattenableType(fn->retType)) {
+        if (fReportScalarReplace) srReturn++;
+        if (canFlattenReturn(fn)) {
+          if (fReportScalarReplace) srReturnReplaced++;
+          flattenReturn(fn);
+        }
+      }
+    }
+  }
+}
+
 
 static void
 debugScalarReplacementFailure(Symbol* var) {
@@ -539,7 +897,7 @@ scalarReplace() {
         typeOrder.put(ct, -1);
         if (ts->hasFlag(FLAG_ITERATOR_CLASS) ||
             ts->hasFlag(FLAG_ITERATOR_RECORD) ||
-            (ts->hasFlag(FLAG_TUPLE) &&
+            ((ts->hasFlag(FLAG_TUPLE) || ts->hasFlag(FLAG_RANGE)) &&
              (ct->fields.length<=scalar_replace_limit))) {
           typeVec.add(ct);
           typeVarMap.put(ct, new Vec<Symbol*>());
@@ -561,6 +919,11 @@ scalarReplace() {
     //
     qsort(typeVec.v, typeVec.n, sizeof(typeVec.v[0]), compareTypesByOrder);
 
+    //
+    // pass and return small records as their fields
+    //
+    flattenRecordArgsAndReturns();
+
     //
     // compute typeVarMap and varSet
     //
@@ -647,6 +1010,11 @@ scalarReplace() {
     if (fReportScalarReplace) {
       printf("\tReplaced %d of %d records\n", srRecordReplaced, srRecord);
       printf("\tReplaced %d of %d classes\n", srClassReplaced, srClass);
+      printf("\tPassed %d of %d record formals as fields\n",
+             srArgReplaced, srArg);
+      printf("\tReturned %d of %d records as fields\n",
+             srReturnReplaced, srReturn);
+      printf("\tRemoved %d record spills at calls\n", srSpillsRemoved);
     }
   }
 }
@@ -175,7 +175,9 @@
 #include "view.h"
 #include <set>
 #include <queue>
+#include <algorithm>
 #include "timer.h"
+#include "compilerTrace.h"
 
 //
 // For debugging, uncomment the following macros for insights:
@@ -216,6 +218,8 @@ static void debug(BaseAST* base, const char* format, ...) {
 
 Timer debugTimer;
 
+static TraceCounter widenedSymbolsVisited("wide symbols propagated");
+
 static std::set<Symbol*> _todo_set;
 static std::queue<Symbol*> _todo_queue;
 
@@ -251,6 +255,7 @@ static void widenGetPrivClass();
 static void moveAddressSourcesToTemp();
 static void fixAST();
 static void handleIsWidePointer();
+static void addTupleDefsUses(CallExpr* call);
 
 static bool isLocalBlock(Expr* stmt) {
   BlockStmt* block = toBlockStmt(stmt);
@@ -934,6 +939,7 @@ static bool shouldRetWide(CallExpr* call) {
 }
 
 static void handleReturns() {
+  TraceRegion            region("handleReturns");
   std::vector<CallExpr*> toRemove;
 
   for_set(CallExpr, call, returnCalls) {
@@ -1001,6 +1007,292 @@ static void handleReturns() {
 //
 
 
+//
+// Functions used to clone functions for wide arguments
+//
+// Normally a formal is widened as soon as one call passes it a wide actual,
+// and that wideness then spreads through the body of the function, so
+// every caller pays for the locality checks that only some of them need.
+//
+// With --wide-arg-clones, a call that would widen a narrow formal is
+// redirected to a clone of the function instead, and only the clone is
+// widened.  All such calls share the one clone, so the original function
+// stays narrow for the calls that pass only local arguments.  If every call
+// ends up using the clone, the original is removed at the end of the pass.
+//
+
+// The wide clone of each function that has one
+static std::map<FnSymbol*, FnSymbol*> wideClones;
+static std::set<FnSymbol*> isWideClone;
+
+// Whether each function seen so far could be cloned
+static std::map<FnSymbol*, bool> canCloneCache;
+
+// Each symbol in a cloned function paired with its copy in the clone
+static std::map<FnSymbol*, std::vector<std::pair<Symbol*, Symbol*> > > cloneSymbols;
+
+// Wide actuals whose formals will be widened by widenPendingActuals()
+static std::vector<SymExpr*> pendingActuals;
+
+static TraceCounter wideClonesMade("functions cloned for wide arguments");
+static TraceCounter wideClonesRemoved("functions replaced by wide clones");
+static TraceCounter wideSymbolsAvoided("symbols kept narrow by wide clones");
+
+//
+// A function can be cloned if every use of it is a direct call that can be
+// redirected, and it has more than one such call.
+//
+static bool canCloneForWideArgs(FnSymbol* fn) {
+  std::map<FnSymbol*, bool>::iterator it = canCloneCache.find(fn);
+
+  if (it != canCloneCache.end()) {
+    return it->second;
+  }
+
+  bool retval = true;
+  int  calls  = 0;
+
+  if (fn->hasFlag(FLAG_EXTERN) ||
+      fn->hasFlag(FLAG_EXPORT) ||
+      fn->hasFlag(FLAG_VIRTUAL) ||
+      fn->hasFlag(FLAG_LOCAL_ARGS) ||
+      fn->hasFlag(FLAG_LOCAL_FN) ||
+      fn->hasFlag(FLAG_ON_BLOCK) ||
+      fn->hasFlag(FLAG_BEGIN_BLOCK) ||
+      fn->hasFlag(FLAG_COBEGIN_OR_COFORALL_BLOCK) ||
+      fn->hasFlag(FLAG_MODULE_INIT) ||
+      fn == chpl_gen_main) {
+    retval = false;
+  }
+
+  if (std::find(ftableVec.begin(), ftableVec.end(), fn) != ftableVec.end()) {
+    retval = false;
+  }
+
+  for_SymbolSymExprs(se, fn) {
+    if (se->inTree()) {
+      CallExpr* call = toCallExpr(se->parentExpr);
+      if (call == NULL || call->baseExpr != se) {
+        retval = false;
+      }
+      calls++;
+    }
+  }
+
+  retval = retval && calls > 1;
+  canCloneCache[fn] = retval;
+
+  return retval;
+}
+
+//
+// Record the calls a clone makes and the symbols it uses, as
+// compute_call_sites(), buildDefUseMaps() and buildTupleDefsUses() did for
+// the rest of the program.
+//
+static void addCloneDefsUses(FnSymbol* fn, FnSymbol* clone) {
+  std::vector<CallExpr*> calls;
+  std::vector<CallExpr*> cloneCalls;
+  std::vector<SymExpr*>  symExprs;
+
+  collectCallExprs(fn, calls);
+  collectCallExprs(clone, cloneCalls);
+  INT_ASSERT(calls.size() == cloneCalls.size());
+
+  for (size_t i = 0; i < cloneCalls.size(); i++) {
+    CallExpr* call = cloneCalls[i];
+
+    if (FnSymbol* callee = call->isResolved()) {
+      if (callee->calledBy) {
+        callee->calledBy->add(call);
+      }
+    } else if (call->isPrimitive(PRIM_VIRTUAL_METHOD_CALL)) {
+      FnSymbol* vFn = toFnSymbol(toSymExpr(call->get(1))->symbol());
+      vFn->calledBy->add(call);
+      if (Vec<FnSymbol*>* children = virtualChildrenMap.get(vFn)) {
+        forv_Vec(FnSymbol, child, *children) {
+          child->calledBy->add(call);
+        }
+      }
+    }
+
+    // The wideness of what the original call returns is still to be decided
+    if (returnCalls.count(calls[i]) != 0) {
+      returnCalls.insert(call);
+    }
+
+    addTupleDefsUses(call);
+  }
+
+  collectSymExprs(clone, symExprs);
+  for_vector(SymExpr, se, symExprs) {
+    if (isLcnSymbol(se->symbol())) {
+      int result = isDefAndOrUse(se);
+
+      if (result & 1) {
+        addDef(defMap, se);
+      }
+      if (result & 2) {
+        addUse(useMap, se);
+      }
+    }
+  }
+}
+
+static FnSymbol* getWideClone(FnSymbol* fn) {
+  if (FnSymbol* clone = wideClones[fn]) {
+    return clone;
+  }
+
+  SET_LINENO(fn);
+  SymbolMap map;
+  FnSymbol* clone = fn->copy(&map);
+
+  clone->name = astr("_wide_", fn->name);
+  clone->cname = astr("_wide_", fn->cname);
+  clone->calledBy = new Vec<CallExpr*>();
+  fn->defPoint->insertBefore(new DefExpr(clone));
+
+  wideClones[fn] = clone;
+  isWideClone.insert(clone);
+  wideClonesMade.Add();
+
+  addCloneDefsUses(fn, clone);
+
+  // The clone starts out exactly as wide as the original is now. Its wide
+  // symbols still need to be propagated through the clone.
+  std::vector<std::pair<Symbol*, Symbol*> >& pairs = cloneSymbols[fn];
+  form_Map(SymbolMapElem, e, map) {
+    if (isLcnSymbol(e->key) && isLcnSymbol(e->value)) {
+      pairs.push_back(std::make_pair(e->key, e->value));
+      addToQueue(e->value);
+    }
+  }
+
+  return clone;
+}
+
+//
+// Redirect 'call' from 'fn' to its wide clone. The wideness of the actuals
+// now applies to the formals of the clone.
+//
+static void redirectToWideClone(CallExpr* call, FnSymbol* fn) {
+  FnSymbol* clone = getWideClone(fn);
+
+  DEBUG_PRINTF("Redirecting call %d from %s (%d) to its wide clone\n", call->id, fn->cname, fn->id);
+
+  {
+    for_formals_actuals(formal, actual, call) {
+      causes[formal].erase(actual);
+    }
+  }
+
+  SET_LINENO(call);
+  call->baseExpr->replace(new SymExpr(clone));
+
+  for (int i = 0; i < fn->calledBy->n; i++) {
+    if (fn->calledBy->v[i] == call) {
+      fn->calledBy->remove(i);
+      break;
+    }
+  }
+  clone->calledBy->add(call);
+
+  {
+    for_formals_actuals(formal, actual, call) {
+      if (hasSomeWideness(actual)) {
+        matchWide(actual, formal);
+      }
+    }
+  }
+}
+
+//
+// The actual 'use' is wide. Widen the corresponding formal, unless the
+// function may be cloned instead, in which case wait until the current
+// round of propagation is done.
+//
+static void widenFormal(SymExpr* use) {
+  CallExpr*  call = toCallExpr(use->parentExpr);
+  FnSymbol*  fn   = call->isResolved();
+  ArgSymbol* arg  = actual_to_formal(use);
+
+  if (fWideArgClones &&
+      !hasSomeWideness(arg) &&
+      typeCanBeWide(arg) &&
+      isWideClone.count(fn) == 0 &&
+      canCloneForWideArgs(fn)) {
+    pendingActuals.push_back(use);
+  } else {
+    matchWide(use, arg);
+  }
+}
+
+//
+// The maps cannot be updated while propagateVar() is walking them, so the
+// calls are redirected between rounds of propagation.
+//
+static void widenPendingActuals() {
+  std::vector<SymExpr*> actuals;
+
+  actuals.swap(pendingActuals);
+
+  for_vector(SymExpr, actual, actuals) {
+    CallExpr*  call = toCallExpr(actual->parentExpr);
+    FnSymbol*  fn   = call->isResolved();
+    ArgSymbol* arg  = actual_to_formal(actual);
+
+    // The formal may have been widened some other way in the meantime, and
+    // an earlier actual may have already redirected the call.
+    if (!hasSomeWideness(arg) && isWideClone.count(fn) == 0) {
+      redirectToWideClone(call, fn);
+    } else {
+      matchWide(actual, arg);
+    }
+  }
+}
+
+// Count the symbols that are narrow in a function but wide in its clone
+static void countWideSymbolsAvoided() {
+  for (std::map<FnSymbol*, FnSymbol*>::iterator it = wideClones.begin();
+       it != wideClones.end(); ++it) {
+    if (!it->first->inTree()) continue;
+
+    std::vector<std::pair<Symbol*, Symbol*> >& pairs = cloneSymbols[it->first];
+
+    for (size_t i = 0; i < pairs.size(); i++) {
+      if (!hasSomeWideness(pairs[i].first) && hasSomeWideness(pairs[i].second)) {
+        wideSymbolsAvoided.Add();
+      }
+    }
+  }
+}
+
+// Remove the functions whose calls were all redirected to their clones
+static void removeReplacedFunctions() {
+  for (std::map<FnSymbol*, FnSymbol*>::iterator it = wideClones.begin();
+       it != wideClones.end(); ++it) {
+    FnSymbol* fn     = it->first;
+    bool      called = false;
+
+    for_SymbolSymExprs(se, fn) {
+      if (se->inTree()) {
+        called = true;
+      }
+    }
+
+    if (!called) {
+      fn->defPoint->remove();
+      wideClonesRemoved.Add();
+    }
+  }
+}
+
+//
+// End of functions used to clone functions for wide arguments
+//
+
+
 //
 // Convert dtNil to dtObject.
 // dtNil is a special type (like void*) that can be converted to any class type.
@@ -1173,6 +1465,8 @@ static void widenSubAggregateTypes(BaseAST* cause, Type* parent) {
 // Widen variables that we don't know how to keep narrow.
 //
 static void addKnownWides() {
+  TraceRegion region("addKnownWides");
+
   forv_Vec(FnSymbol, fn, gFnSymbols) {
     if (fn->hasFlag(FLAG_ON_BLOCK) && !fn->hasFlag(FLAG_LOCAL_ON)) {
       // Get the arg bundle type for an on-stmt. Testing against a name like
@@ -1496,11 +1790,9 @@ static void propagateVar(Symbol* sym) {
       else if (FnSymbol* fn = call->isResolved()) {
         debug(sym, "passed to fn %s (%d)\n", fn->cname, fn->id);
 
-        // TODO: Duplicate functions here.
-
         ArgSymbol* arg = actual_to_formal(use);
         debug(sym, "Default widening of arg %s (%d)\n", arg->cname, arg->id);
-        matchWide(use, arg);
+        widenFormal(use);
       }
     }
   }
@@ -1510,8 +1802,7 @@ static void propagateVar(Symbol* sym) {
     if (CallExpr* call = toCallExpr(def->parentExpr)) {
       if (call->isResolved()) {
         debug(sym, "Widening def arg\n");
-        ArgSymbol* arg = actual_to_formal(def);
-        matchWide(def, arg);
+        widenFormal(def);
       }
       else if (call->isPrimitive(PRIM_MOVE) || call->isPrimitive(PRIM_ASSIGN)) {
         if (CallExpr* rhs = toCallExpr(call->get(2))) {
@@ -1725,6 +2016,8 @@ static void widenGetPrivClass()
 
 static void narrowWideClassesThroughCalls()
 {
+  TraceRegion region("narrowWideClassesThroughCalls");
+
   //
   // Turn calls to functions with local arguments (e.g. extern or export
   // functions) involving wide classes
@@ -2061,6 +2354,7 @@ static void localizeCall(CallExpr* call) {
 //   - Within a local block, eliminate on-statement overhead
 //
 static void handleLocalBlocks() {
+  TraceRegion region("handleLocalBlocks");
   Map<FnSymbol*,FnSymbol*> cache; // cache of localized functions
   Vec<BlockStmt*> queue; // queue of blocks to localize
 
@@ -2274,6 +2568,8 @@ static void insertNodeComparison(Expr* stmt, SymExpr* lhs, SymExpr* rhs) {
 
 
 static void fixAST() {
+  TraceRegion region("fixAST");
+
   forv_Vec(CallExpr, call, gCallExprs) {
     if (!isAlive(call)) continue;
 
@@ -2552,6 +2848,8 @@ static void fixAST() {
 //     replace the rhs of the move with the temp.
 static void moveAddressSourcesToTemp()
 {
+  TraceRegion region("moveAddressSourcesToTemp");
+
   forv_Vec(CallExpr, call, gCallExprs) {
     if (call->isPrimitive(PRIM_MOVE) || call->isPrimitive(PRIM_ASSIGN)) {
       if (call->get(1)->isRefOrWideRef() &&
@@ -2594,35 +2892,39 @@ static void addTupleDefOrUse(Map<Symbol*, Vec<SymExpr*>*>& ses, Symbol* field, E
 // buildDefUseMaps does not handle tuple fields correctly, star tuples
 // especially. This function tries to do a better job.
 //
-static void buildTupleDefsUses() {
-  // TODO: The incorrect defs/uses from buildDefUseMaps may still
-  // exist, can we do anything about that?
-  forv_Vec(CallExpr, call, gCallExprs) {
-    if (call->isPrimitive(PRIM_GET_SVEC_MEMBER) ||
-        call->isPrimitive(PRIM_GET_SVEC_MEMBER_VALUE) ||
-        call->isPrimitive(PRIM_SET_SVEC_MEMBER)) {
-      Symbol* field = getSvecSymbol(call);
-      if (field) {
+static void addTupleDefsUses(CallExpr* call) {
+  if (call->isPrimitive(PRIM_GET_SVEC_MEMBER) ||
+      call->isPrimitive(PRIM_GET_SVEC_MEMBER_VALUE) ||
+      call->isPrimitive(PRIM_SET_SVEC_MEMBER)) {
+    Symbol* field = getSvecSymbol(call);
+    if (field) {
+      if (call->isPrimitive(PRIM_SET_SVEC_MEMBER)) {
+        addTupleDefOrUse(defMap, field, call->get(2));
+      } else {
+        addTupleDefOrUse(useMap, field, call->get(2));
+      }
+    } else {
+      // indexed by a runtime value, need to add all fields.
+      AggregateType* ag = toAggregateType(call->get(1)->getValType());
+      for_fields(fi, ag) {
         if (call->isPrimitive(PRIM_SET_SVEC_MEMBER)) {
-          addTupleDefOrUse(defMap, field, call->get(2));
+          addTupleDefOrUse(defMap, fi, call->get(2));
         } else {
-          addTupleDefOrUse(useMap, field, call->get(2));
-        }
-      } else {
-        // indexed by a runtime value, need to add all fields.
-        AggregateType* ag = toAggregateType(call->get(1)->getValType());
-        for_fields(fi, ag) {
-          if (call->isPrimitive(PRIM_SET_SVEC_MEMBER)) {
-            addTupleDefOrUse(defMap, fi, call->get(2));
-          } else {
-            addTupleDefOrUse(useMap, fi, call->get(2));
-          }
+          addTupleDefOrUse(useMap, fi, call->get(2));
         }
       }
     }
   }
 }
 
+static void buildTupleDefsUses() {
+  // TODO: The incorrect defs/uses from buildDefUseMaps may still
+  // exist, can we do anything about that?
+  forv_Vec(CallExpr, call, gCallExprs) {
+    addTupleDefsUses(call);
+  }
+}
+
 void handleIsWidePointer() {
   forv_Vec(CallExpr, call, gCallExprs) {
     if (call->isPrimitive(PRIM_IS_WIDE_PTR)) {
@@ -2748,12 +3050,15 @@ insertWideReferences(void) {
   //
   int numIters = 0;
   while (!queueEmpty()) {
+    TraceRegion region("propagateWideness");
+
     DEBUG_PRINTF("Propagation Iteration %d\n\n", numIters);
     numIters += 1;
 
     // Propagate as far as we can...
     while (!queueEmpty()) {
       Symbol* sym = queuePop();
+      widenedSymbolsVisited.Add();
       if (isField(sym)) {
         propagateField(sym);
       } else {
@@ -2761,6 +3066,9 @@ insertWideReferences(void) {
       }
     }
 
+    // ... then widen the formals that were left narrow for cloning ...
+    widenPendingActuals();
+
     // ... then deal with the return of wide pointers
     handleReturns();
   }
@@ -2805,6 +3113,9 @@ insertWideReferences(void) {
 
   handleIsWidePointer();
 
+  removeReplacedFunctions();
+  countWideSymbolsAvoided();
+
 
 #ifdef PRINT_WIDEN_SUMMARY
   printf("Spent %2.3f seconds propagating vars\n", debugTimer.elapsedSecs());
@@ -24,9 +24,11 @@
 #include "passes.h"
 
 #include "astutil.h"
+#include "compilerTrace.h"
 #include "driver.h"
 #include "expr.h"
 #include "files.h"
+#include "LoopStmt.h"
 #include "optimizations.h"
 #include "resolution.h"
 #include "stlUtil.h"
@@ -875,6 +877,188 @@ buildHeapType(Type* type) {
 }
 
 
+//
+// Escape analysis for heap-allocated locals.
+//
+// A local that an 'on' statement may access remotely must live on the heap,
+// because remote nodes cannot access task stacks.  Its heap cell is freed
+// when the local goes out of scope, unless a task that can outlive the
+// scope may still use it.  Tasks started by 'cobegin', 'coforall' and 'on'
+// are joined before their statement ends; tasks started by 'begin' are
+// joined by an enclosing 'sync' statement, if any.
+//
+// If every task that uses the local is joined before the end of an
+// iteration of the loop declaring it, the cell does not escape the
+// iteration and is allocated once around the outermost such loop in the
+// function instead of once per iteration.
+//
+
+static TraceCounter heapVarsHoisted("heap-allocated locals hoisted out of loops");
+static TraceCounter heapVarsJoined("heap-allocated locals freed after a sync");
+
+//
+// Is the begin task started by this call joined by a 'sync' statement
+// inside the scope of var?  The sync statement installs a new end count
+// with PRIM_SET_END_COUNT and waits for it with _waitEndCount() (cobegin
+// and coforall pass their end counts explicitly).  The task is joined by
+// the first such wait after it in an enclosing block, unless the end count
+// is replaced first.
+//
+static bool
+isJoinedInScope(CallExpr* call, Symbol* var) {
+  Expr* scope = var->defPoint->parentExpr;
+
+  for (Expr* stmt = call->getStmtExpr(); stmt != NULL && stmt != scope;
+       stmt = stmt->parentExpr) {
+    if (isBlockStmt(stmt->parentExpr) == true) {
+      for (Expr* next = stmt->next; next != NULL; next = next->next) {
+        if (CallExpr* nextCall = toCallExpr(next)) {
+          FnSymbol* fn = nextCall->isResolved();
+
+          if (nextCall->isPrimitive(PRIM_SET_END_COUNT) == true) {
+            break;
+
+          } else if (fn                    != NULL                  &&
+                     fn->name              == astr("_waitEndCount") &&
+                     nextCall->numActuals() == 0) {
+            return true;
+          }
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
+// The label a break in the loop jumps to: the first label defined after
+// the loop in it or the blocks enclosing it, provided that no statement
+// between the loop and the label jumps elsewhere.
+static DefExpr*
+findLoopExitLabel(LoopStmt* loop) {
+  for (Expr* stmt = loop;
+       stmt != NULL && stmt->parentExpr != NULL;
+       stmt = stmt->parentExpr) {
+    if (isBlockStmt(stmt->parentExpr) == false ||
+        isLoopStmt(stmt->parentExpr)  == true) {
+      break;
+    }
+
+    for (Expr* next = stmt->next; next != NULL; next = next->next) {
+      std::vector<GotoStmt*> gotoStmts;
+
+      if (DefExpr* def = toDefExpr(next)) {
+        if (isLabelSymbol(def->sym)) {
+          return def;
+        }
+      }
+
+      collectGotoStmts(next, gotoStmts);
+
+      if (gotoStmts.size() > 0) {
+        return NULL;
+      }
+    }
+  }
+
+  return NULL;
+}
+
+// Can a heap cell be allocated before and freed after this loop?  Nothing
+// but the end of the loop or a break may leave it, so the free is not
+// skipped.
+static bool
+canHoistHeapVar(LoopStmt* loop) {
+  std::vector<GotoStmt*> gotoStmts;
+  bool                   retval = true;
+
+  collectGotoStmts(loop, gotoStmts);
+
+  for_vector(GotoStmt, gotoStmt, gotoStmts) {
+    LabelSymbol* target = gotoStmt->gotoTarget();
+    bool         inside = false;
+
+    if (target == NULL) {
+      retval = false;
+
+    } else if (target->defPoint != findLoopExitLabel(loop)) {
+      // Anything but a break must stay inside the loop
+      for (Expr* expr = target->defPoint; expr; expr = expr->parentExpr) {
+        if (expr == loop) {
+          inside = true;
+        }
+      }
+
+      retval = retval && inside;
+    }
+  }
+
+  return retval;
+}
+
+static LoopStmt*
+findHeapVarHoistLoop(Symbol* var) {
+  FnSymbol* fn     = toFnSymbol(var->defPoint->parentSymbol);
+  LoopStmt* retval = NULL;
+
+  if (fn != NULL) {
+    for (Expr* expr = var->defPoint->parentExpr;
+         expr != NULL && expr != fn->body;
+         expr = expr->parentExpr) {
+      if (LoopStmt* loop = toLoopStmt(expr)) {
+        if (canHoistHeapVar(loop) == false) {
+          break;
+        }
+
+        retval = loop;
+      }
+    }
+  }
+
+  return retval;
+}
+
+//
+// Move var's definition and the allocation of its heap cell, which
+// insertChplHereAlloc() put right after it, before the loop.  Returns the
+// statement after which to free the cell, or NULL if the allocation does
+// not have the expected form.
+//
+static Expr*
+hoistHeapVar(Symbol* var, LoopStmt* loop) {
+  std::vector<Expr*> stmts;
+  Expr*              stmt   = var->defPoint;
+  Expr*              retval = loop;
+
+  stmts.push_back(stmt);
+
+  for (int i = 0; i < 5 && stmt != NULL; i++) {
+    stmt = stmt->next;
+    stmts.push_back(stmt);
+  }
+
+  CallExpr* cast = toCallExpr(stmt);
+
+  if (cast                                             == NULL  ||
+      cast->isPrimitive(PRIM_MOVE)                     == false ||
+      toSymExpr(cast->get(1))                          == NULL  ||
+      toSymExpr(cast->get(1))->symbol()                != var   ||
+      isCallExpr(cast->get(2))                         == false ||
+      toCallExpr(cast->get(2))->isPrimitive(PRIM_CAST) == false) {
+    return NULL;
+  }
+
+  for_vector(Expr, hoisted, stmts) {
+    loop->insertBefore(hoisted->remove());
+  }
+
+  if (DefExpr* exitLabel = findLoopExitLabel(loop)) {
+    retval = exitLabel;
+  }
+
+  return retval;
+}
+
 static void
 freeHeapAllocatedVars(Vec<Symbol*> heapAllocatedVars) {
   Vec<FnSymbol*> fnsContainingTaskll;
@@ -921,6 +1105,7 @@ freeHeapAllocatedVars(Vec<Symbol*> heapAllocatedVars) {
     }
     if (defs->n == 1) {
       bool freeVar = true;
+      bool joined = false;
       Vec<Symbol*> varsToTrack;
       varsToTrack.add(var);
       forv_Vec(Symbol, v, varsToTrack) {
@@ -947,8 +1132,12 @@ freeHeapAllocatedVars(Vec<Symbol*> heapAllocatedVars) {
                 }
               }
               else if (fnsContainingTaskll.in(call->isResolved())) {
-                freeVar = false;
-                break;
+                if (fNoHeapVarEscapeAnalysis ||
+                    !isJoinedInScope(call, var)) {
+                  freeVar = false;
+                  break;
+                }
+                joined = true;
               }
             }
           }
@@ -1003,7 +1192,21 @@ freeHeapAllocatedVars(Vec<Symbol*> heapAllocatedVars) {
         }
         FnSymbol* fn = toFnSymbol(move->parentSymbol);
         SET_LINENO(var);
-        if (fn && innermostBlock == fn->body)
+        LoopStmt* loop = NULL;
+        Expr* freeAfter = NULL;
+        if (!fNoHeapVarEscapeAnalysis)
+          loop = findHeapVarHoistLoop(var);
+        if (loop)
+          freeAfter = hoistHeapVar(var, loop);
+        if (joined) {
+          // free after the sync statements joining the tasks
+          innermostBlock = var->defPoint->parentExpr;
+          heapVarsJoined.Add();
+        }
+        if (freeAfter) {
+          freeAfter->insertAfter(callChplHereFree(move->get(1)->copy()));
+          heapVarsHoisted.Add();
+        } else if (fn && innermostBlock == fn->body)
           fn->insertBeforeReturnAfterLabel(callChplHereFree(move->get(1)->copy()));
         else {
           BlockStmt* block = toBlockStmt(innermostBlock);
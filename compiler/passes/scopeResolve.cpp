@@ -2046,7 +2046,7 @@ static void renameDefaultType(Type* type, const char* newname) {
 static void lookup(BaseAST* scope, const char * name,
                    std::vector<Symbol* >& symbols,
                    Vec<BaseAST*>& alreadyVisited,
-                   std::set<int> rejectedPrivateIds,
+                   std::set<int>& rejectedPrivateIds,
                    BaseAST* callingContext);
 
 
@@ -2177,10 +2177,13 @@ static bool methodMatched(BaseAST* scope, FnSymbol* method) {
 // inSymbolTable returns a Symbol* if there was an entry for this scope
 // that matched this name, NULL otherwise.
 static Symbol* inSymbolTable(BaseAST* scope, const char* name) {
-  if (symbolTable.count(scope) != 0) {
-    SymbolTableEntry* entry = symbolTable[scope];
-    if (entry->count(name) != 0) {
-      Symbol* sym = (*entry)[name];
+  SymbolTable::iterator entry = symbolTable.find(scope);
+
+  if (entry != symbolTable.end()) {
+    SymbolTableEntry::iterator it = entry->second->find(name);
+
+    if (it != entry->second->end()) {
+      Symbol* sym = it->second;
       // If the symbol found isn't a method, or it was a method and we are
       // in the appropriate scope to add it (as determined by calling
       // methodMatched), then return the symbol
@@ -2226,7 +2229,7 @@ static bool isRepeat(std::vector<Symbol* >& symbols, Symbol* toAdd) {
 // Assumes that symbols contains nothing before entering this function
 static bool lookupThisScopeAndUses(BaseAST* scope, const char * name,
                                    std::vector<Symbol* >& symbols,
-                                   std::set<int> rejectedPrivateIds,
+                                   std::set<int>& rejectedPrivateIds,
                                    BaseAST* callingContext) {
   INT_ASSERT(symbols.size() == 0);
 
@@ -2261,9 +2264,11 @@ static bool lookupThisScopeAndUses(BaseAST* scope, const char * name,
     // Nothing found so far, look into the uses.
     if (BlockStmt* block = toBlockStmt(scope)) {
       if (block->modUses) {
+        std::map<BlockStmt*,Vec<UseStmt*>*>::iterator cached =
+          moduleUsesCache.find(block);
         Vec<UseStmt*>* moduleUses = NULL;
 
-        if (moduleUsesCache.count(block) == 0) {
+        if (cached == moduleUsesCache.end()) {
           moduleUses = new Vec<UseStmt*>();
 
           for_actuals(expr, block->modUses) {
@@ -2280,7 +2285,7 @@ static bool lookupThisScopeAndUses(BaseAST* scope, const char * name,
           if (enableModuleUsesCache)
             moduleUsesCache[block] = moduleUses;
         } else {
-          moduleUses = moduleUsesCache[block];
+          moduleUses = cached->second;
         }
 
         forv_Vec(UseStmt, use, *moduleUses) {
@@ -2356,7 +2361,7 @@ static bool lookupThisScopeAndUses(BaseAST* scope, const char * name,
 static void lookup(BaseAST* scope, const char * name,
                    std::vector<Symbol* >& symbols,
                    Vec<BaseAST*>& alreadyVisited,
-                   std::set<int> rejectedPrivateIds,
+                   std::set<int>& rejectedPrivateIds,
                    BaseAST* callingContext) {
   if (!alreadyVisited.set_in(scope)) {
     alreadyVisited.set_add(scope);
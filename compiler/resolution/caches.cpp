@@ -19,25 +19,230 @@
 
 #include "astutil.h"
 #include "caches.h"
+#include "expr.h"
+#include "resolution.h"
 #include "stmt.h"
 #include "stringutil.h"
+#include "symbol.h"
 
+#include <stdint.h>
 
-SymbolMapCacheEntry::SymbolMapCacheEntry(FnSymbol* ifn, SymbolMap* imap) :
-  fn(ifn), map(*imap) { }
+
+// Grow the bucket array once the average chain would exceed this length
+#define CACHE_MAX_LOAD 2
+#define CACHE_INITIAL_BUCKETS 64
+
+
+/************************************* | **************************************
+*                                                                             *
+* Hashing helpers                                                             *
+*                                                                             *
+************************************** | *************************************/
+
+static inline unsigned int
+hashPointer(void* p) {
+  uint64_t x = (uint64_t)(uintptr_t) p;
+
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+
+  return (unsigned int) x;
+}
+
+//
+// The hash of a map must not depend on the order in which its
+// key-value pairs are stored, so the per-pair hashes are summed.
+// Pairs with a NULL value are skipped since isCacheEntryMatch()
+// treats them the same as a missing key.
+//
+static unsigned int
+hashSymbolMap(SymbolMap* map) {
+  unsigned int h = 0;
+
+  form_Map(SymbolMapElem, e, *map) {
+    if (e->value)
+      h += hashPointer(e->key) * 31 + hashPointer(e->value);
+  }
+
+  return h;
+}
+
+//
+// Vectors are compared as sets, so repeated elements are only
+// counted once.
+//
+static unsigned int
+hashSymbolVec(Vec<Symbol*>* vec) {
+  unsigned int h = 0;
+
+  for (int i = 0; i < vec->n; i++) {
+    bool seen = false;
+
+    for (int j = 0; j < i && !seen; j++)
+      seen = vec->v[j] == vec->v[i];
+
+    if (!seen)
+      h += hashPointer(vec->v[i]);
+  }
+
+  return h;
+}
+
+static inline unsigned int
+combineHash(FnSymbol* fn, unsigned int h) {
+  return hashPointer(fn) ^ (h + 0x9e3779b9 + (h << 6) + (h >> 2));
+}
+
+
+/************************************* | **************************************
+*                                                                             *
+* Bucket management shared by SymbolMapCache and SymbolVecCache               *
+*                                                                             *
+************************************** | *************************************/
+
+//
+// Entries are appended to the end of their chain (and rehashing keeps
+// the chain order) so that, as with the original vector-based caches,
+// the oldest matching entry is the one found by a lookup.
+//
+template <class Entry> static void
+appendToBucket(std::vector<Entry*>& buckets, Entry* entry) {
+  Entry** link = &buckets[entry->hash & (buckets.size() - 1)];
+
+  while (*link != NULL)
+    link = &(*link)->next;
+
+  entry->next = NULL;
+  *link       = entry;
+}
+
+template <class Entry> static void
+insertEntry(std::vector<Entry*>& buckets, int& numEntries, Entry* entry) {
+  if (buckets.size() == 0) {
+    buckets.resize(CACHE_INITIAL_BUCKETS, NULL);
+
+  } else if ((size_t) numEntries >= buckets.size() * CACHE_MAX_LOAD) {
+    std::vector<Entry*> old;
+
+    old.swap(buckets);
+    buckets.resize(old.size() * 2, NULL);
+
+    for (size_t i = 0; i < old.size(); i++) {
+      Entry* e = old[i];
+
+      while (e) {
+        Entry* next = e->next;
+
+        appendToBucket(buckets, e);
+
+        e = next;
+      }
+    }
+  }
+
+  appendToBucket(buckets, entry);
+
+  numEntries = numEntries + 1;
+}
+
+template <class Entry> static inline Entry*
+bucketHead(std::vector<Entry*>& buckets, unsigned int hash) {
+  return (buckets.size() == 0) ? NULL : buckets[hash & (buckets.size() - 1)];
+}
+
+template <class Entry> static void
+freeEntries(std::vector<Entry*>& buckets, int& numEntries) {
+  for (size_t i = 0; i < buckets.size(); i++) {
+    Entry* e = buckets[i];
+
+    while (e) {
+      Entry* next = e->next;
+
+      delete e;
+
+      e = next;
+    }
+  }
+
+  buckets.clear();
+  numEntries = 0;
+}
+
+
+/************************************* | **************************************
+*                                                                             *
+* CacheStats                                                                  *
+*                                                                             *
+************************************** | *************************************/
+
+CacheStats::CacheStats() {
+  reset();
+}
+
+void CacheStats::reset() {
+  hits       = 0;
+  misses     = 0;
+  probes     = 0;
+  maxProbe   = 0;
+  maxEntries = 0;
+}
+
+void CacheStats::noteLookup(int probeLength, bool hit) {
+  if (hit)
+    hits++;
+  else
+    misses++;
+
+  probes += probeLength;
+
+  if (probeLength > maxProbe)
+    maxProbe = probeLength;
+}
+
+void CacheStats::noteInsert(int numEntries) {
+  if (numEntries > maxEntries)
+    maxEntries = numEntries;
+}
+
+void CacheStats::print(FILE* fp, const char* name) const {
+  unsigned long lookups = hits + misses;
+  double        avg     = (lookups > 0) ? (double) probes / lookups : 0.0;
+
+  fprintf(fp,
+          "%16s : %9lu hits %9lu misses %9d entries "
+          "%8.2f avg probe %6d max probe\n",
+          name, hits, misses, maxEntries, avg, maxProbe);
+}
+
+
+/************************************* | **************************************
+*                                                                             *
+* SymbolMapCache                                                              *
+*                                                                             *
+************************************** | *************************************/
+
+SymbolMapCacheEntry::SymbolMapCacheEntry(FnSymbol*    ioldFn,
+                                         FnSymbol*    ifn,
+                                         SymbolMap*   imap,
+                                         unsigned int ihash) :
+  oldFn(ioldFn), fn(ifn), map(*imap), hash(ihash), next(NULL) { }
+
+
+SymbolMapCache::SymbolMapCache(const char* iname) :
+  name(iname), numEntries(0) { }
 
 
 void
 addCache(SymbolMapCache& cache, FnSymbol* oldFn, FnSymbol* fn, SymbolMap* map) {
-  Vec<SymbolMapCacheEntry*>* entries = cache.get(oldFn);
-  SymbolMapCacheEntry* entry = new SymbolMapCacheEntry(fn, map);
-  if (entries) {
-    entries->add(entry);
-  } else {
-    entries = new Vec<SymbolMapCacheEntry*>();
-    entries->add(entry);
-    cache.put(oldFn, entries);
-  }
+  unsigned int         hash  = combineHash(oldFn, hashSymbolMap(map));
+  SymbolMapCacheEntry* entry = new SymbolMapCacheEntry(oldFn, fn, map, hash);
+
+  insertEntry(cache.buckets, cache.numEntries, entry);
+
+  cache.stats.noteInsert(cache.numEntries);
 }
 
 
@@ -53,27 +258,42 @@ isCacheEntryMatch(SymbolMap* s1, SymbolMap* s2) {
 }
 
 
+static SymbolMapCacheEntry*
+findEntry(SymbolMapCache& cache, FnSymbol* oldFn, SymbolMap* map) {
+  unsigned int         hash   = combineHash(oldFn, hashSymbolMap(map));
+  SymbolMapCacheEntry* retval = NULL;
+  int                  probes = 0;
+
+  for (SymbolMapCacheEntry* entry = bucketHead(cache.buckets, hash);
+       entry != NULL && retval == NULL;
+       entry = entry->next) {
+    probes++;
+
+    if (entry->hash  == hash  &&
+        entry->oldFn == oldFn &&
+        isCacheEntryMatch(map, &entry->map))
+      retval = entry;
+  }
+
+  cache.stats.noteLookup(probes, retval != NULL);
+
+  return retval;
+}
+
+
 FnSymbol*
 checkCache(SymbolMapCache& cache, FnSymbol* oldFn, SymbolMap* map) {
-  if (Vec<SymbolMapCacheEntry*>* entries = cache.get(oldFn)) {
-    forv_Vec(SymbolMapCacheEntry, entry, *entries) {
-      if (isCacheEntryMatch(map, &entry->map))
-        return entry->fn;
-    }
-  }
-  return NULL;
+  SymbolMapCacheEntry* entry = findEntry(cache, oldFn, map);
+
+  return (entry != NULL) ? entry->fn : NULL;
 }
 
 
 void
 replaceCache(SymbolMapCache& cache, FnSymbol* oldFn, FnSymbol* fn, SymbolMap* map) {
-  if (Vec<SymbolMapCacheEntry*>* entries = cache.get(oldFn)) {
-    forv_Vec(SymbolMapCacheEntry, entry, *entries) {
-      if (isCacheEntryMatch(map, &entry->map)) {
-        entry->fn = fn;
-        return;
-      }
-    }
+  if (SymbolMapCacheEntry* entry = findEntry(cache, oldFn, map)) {
+    entry->fn = fn;
+    return;
   }
   INT_FATAL(oldFn, "unable to replace cache entry; entry does not exist");
 }
@@ -81,30 +301,35 @@ replaceCache(SymbolMapCache& cache, FnSymbol* oldFn, FnSymbol* fn, SymbolMap* ma
 
 void
 freeCache(SymbolMapCache& cache) {
-  form_Map(SymbolMapCacheElem, elem, cache) {
-    forv_Vec(SymbolMapCacheEntry, entry, *elem->value) {
-      delete entry;
-    }
-    delete elem->value;
-  }
-  cache.clear();
+  freeEntries(cache.buckets, cache.numEntries);
 }
 
 
-SymbolVecCacheEntry::SymbolVecCacheEntry(FnSymbol* ifn, Vec<Symbol*>* ivec) :
-  fn(ifn), vec(*ivec) { }
+/************************************* | **************************************
+*                                                                             *
+* SymbolVecCache                                                              *
+*                                                                             *
+************************************** | *************************************/
+
+SymbolVecCacheEntry::SymbolVecCacheEntry(FnSymbol*     ioldFn,
+                                         FnSymbol*     ifn,
+                                         Vec<Symbol*>* ivec,
+                                         unsigned int  ihash) :
+  oldFn(ioldFn), fn(ifn), vec(*ivec), hash(ihash), next(NULL) { }
+
+
+SymbolVecCache::SymbolVecCache(const char* iname) :
+  name(iname), numEntries(0) { }
 
 
 void
 addCache(SymbolVecCache& cache, FnSymbol* oldFn, FnSymbol* fn, Vec<Symbol*>* vec) {
-  Vec<SymbolVecCacheEntry*>* entries = cache.get(oldFn);
-  if (entries) {
-    entries->add(new SymbolVecCacheEntry(fn, vec));
-  } else {
-    entries = new Vec<SymbolVecCacheEntry*>();
-    entries->add(new SymbolVecCacheEntry(fn, vec));
-    cache.put(oldFn, entries);
-  }
+  unsigned int         hash  = combineHash(oldFn, hashSymbolVec(vec));
+  SymbolVecCacheEntry* entry = new SymbolVecCacheEntry(oldFn, fn, vec, hash);
+
+  insertEntry(cache.buckets, cache.numEntries, entry);
+
+  cache.stats.noteInsert(cache.numEntries);
 }
 
 
@@ -122,31 +347,239 @@ isCacheEntryMatch(Vec<Symbol*>* vec1, Vec<Symbol*>* vec2) {
 
 FnSymbol*
 checkCache(SymbolVecCache& cache, FnSymbol* fn, Vec<Symbol*>* vec) {
-  if (Vec<SymbolVecCacheEntry*>* entries = cache.get(fn)) {
-    forv_Vec(SymbolVecCacheEntry, entry, *entries) {
-      if (isCacheEntryMatch(vec, &entry->vec)) {
-        return entry->fn;
-      }
-    }
+  unsigned int hash   = combineHash(fn, hashSymbolVec(vec));
+  FnSymbol*    retval = NULL;
+  int          probes = 0;
+
+  for (SymbolVecCacheEntry* entry = bucketHead(cache.buckets, hash);
+       entry != NULL && retval == NULL;
+       entry = entry->next) {
+    probes++;
+
+    if (entry->hash  == hash &&
+        entry->oldFn == fn   &&
+        isCacheEntryMatch(vec, &entry->vec))
+      retval = entry->fn;
   }
-  return NULL;
+
+  cache.stats.noteLookup(probes, retval != NULL);
+
+  return retval;
 }
 
 
 void
 freeCache(SymbolVecCache& cache) {
-  form_Map(SymbolVecCacheElem, elem, cache) {
-    forv_Vec(SymbolVecCacheEntry, entry, *elem->value) {
-      delete entry;
+  freeEntries(cache.buckets, cache.numEntries);
+}
+
+
+/************************************* | **************************************
+*                                                                             *
+* CallResultCache                                                             *
+*                                                                             *
+************************************** | *************************************/
+
+//
+// Params are matched by symbol since candidate filtering and
+// disambiguation may depend on their values; every other actual is
+// matched by its type.
+//
+CallResultCacheActual::CallResultCacheActual(Symbol* actual, const char* iname) :
+  type(actual->type),
+  name(iname),
+  param((actual->isParameter() || actual->isImmediate()) ? actual : NULL),
+  isType(actual->hasFlag(FLAG_TYPE_VARIABLE)) { }
+
+
+bool
+CallResultCacheActual::operator==(const CallResultCacheActual& other) const {
+  return type   == other.type   &&
+         name   == other.name   &&
+         param  == other.param  &&
+         isType == other.isType;
+}
+
+
+//
+// Calls through an explicit module scope (M.call) only see the public
+// functions of that module, so they do not depend on the caller.
+//
+static ModuleSymbol*
+callModule(CallInfo& info) {
+  return (info.scope != NULL) ? NULL : info.call->getModule();
+}
+
+
+static unsigned int
+hashCallShape(BlockStmt* scope, ModuleSymbol* module, CallInfo& info) {
+  unsigned int h = hashPointer(scope) ^ hashPointer((void*) info.name);
+
+  h = h * 31 + hashPointer(module);
+  h = h * 31 + (info.scope           ? 1 : 0);
+  h = h * 31 + (info.call->methodTag ? 1 : 0);
+
+  for (int i = 0; i < info.actuals.n; i++) {
+    Symbol* actual = info.actuals.v[i];
+
+    h = h * 31 + hashPointer(actual->type);
+    h = h * 31 + hashPointer((void*) info.actualNames.v[i]);
+
+    if (actual->isParameter() || actual->isImmediate())
+      h = h * 31 + hashPointer(actual);
+  }
+
+  return h;
+}
+
+
+CallResultCacheEntry::CallResultCacheEntry(BlockStmt*       iscope,
+                                           ModuleSymbol*    imodule,
+                                           CallInfo&        info,
+                                           FnSymbol*        ifn,
+                                           Vec<ArgSymbol*>& iactualIdxToFormal,
+                                           unsigned int     ihash) :
+  scope(iscope),
+  module(imodule),
+  explicitScope(info.scope != NULL),
+  name(info.name),
+  methodTag(info.call->methodTag),
+  fn(ifn),
+  actualIdxToFormal(iactualIdxToFormal),
+  epoch(0),
+  hash(ihash),
+  next(NULL) {
+  for (int i = 0; i < info.actuals.n; i++)
+    actuals.push_back(CallResultCacheActual(info.actuals.v[i],
+                                            info.actualNames.v[i]));
+}
+
+
+bool CallResultCacheEntry::matches(BlockStmt*    iscope,
+                                   ModuleSymbol* imodule,
+                                   CallInfo&     info) const {
+  if (scope                != iscope               ||
+      module               != imodule              ||
+      explicitScope        != (info.scope != NULL) ||
+      name                 != info.name            ||
+      methodTag            != info.call->methodTag ||
+      (int) actuals.size() != info.actuals.n)
+    return false;
+
+  for (int i = 0; i < info.actuals.n; i++) {
+    CallResultCacheActual actual(info.actuals.v[i], info.actualNames.v[i]);
+
+    if (!(actuals[i] == actual))
+      return false;
+  }
+
+  return true;
+}
+
+
+CallResultCache::CallResultCache(const char* iname) :
+  name(iname), numEntries(0) { }
+
+
+void
+addCache(CallResultCache&  cache,
+         BlockStmt*        scope,
+         CallInfo&         info,
+         FnSymbol*         fn,
+         Vec<ArgSymbol*>&  actualIdxToFormal) {
+  ModuleSymbol*         module = callModule(info);
+  unsigned int          hash   = hashCallShape(scope, module, info);
+  CallResultCacheEntry* entry  = new CallResultCacheEntry(scope,
+                                                          module,
+                                                          info,
+                                                          fn,
+                                                          actualIdxToFormal,
+                                                          hash);
+
+  entry->epoch = cache.epochs.get(info.name);
+
+  insertEntry(cache.buckets, cache.numEntries, entry);
+
+  cache.stats.noteInsert(cache.numEntries);
+}
+
+
+//
+// Entries made stale by invalidateCache() are unlinked as they are
+// encountered rather than by a walk over the whole table.
+//
+FnSymbol*
+checkCache(CallResultCache&  cache,
+           BlockStmt*        scope,
+           CallInfo&         info,
+           Vec<ArgSymbol*>&  actualIdxToFormal) {
+  ModuleSymbol* module = callModule(info);
+  unsigned int  hash   = hashCallShape(scope, module, info);
+  int           epoch  = cache.epochs.get(info.name);
+  FnSymbol*     retval = NULL;
+  int           probes = 0;
+
+  if (cache.buckets.size() > 0) {
+    CallResultCacheEntry** link = &cache.buckets[hash & (cache.buckets.size() - 1)];
+
+    while (*link != NULL && retval == NULL) {
+      CallResultCacheEntry* entry = *link;
+
+      probes++;
+
+      if (entry->name == info.name && entry->epoch != epoch) {
+        *link            = entry->next;
+        cache.numEntries = cache.numEntries - 1;
+
+        delete entry;
+
+      } else {
+        if (entry->hash == hash && entry->matches(scope, module, info)) {
+          actualIdxToFormal.copy(entry->actualIdxToFormal);
+          retval = entry->fn;
+        }
+
+        link = &entry->next;
+      }
     }
-    delete elem->value;
   }
-  cache.clear();
+
+  cache.stats.noteLookup(probes, retval != NULL);
+
+  return retval;
+}
+
+
+void
+invalidateCache(CallResultCache& cache, const char* name) {
+  cache.epochs.put(name, cache.epochs.get(name) + 1);
+}
+
+
+void
+freeCache(CallResultCache& cache) {
+  freeEntries(cache.buckets, cache.numEntries);
+  cache.epochs.clear();
 }
 
 
-SymbolMapCache ordersCache;
-SymbolMapCache genericsCache;
-SymbolMapCache coercionsCache;
-SymbolMapCache promotionsCache;
-SymbolVecCache defaultsCache;
+SymbolMapCache ordersCache("orders");
+SymbolMapCache genericsCache("generics");
+SymbolMapCache coercionsCache("coercions");
+SymbolMapCache promotionsCache("promotions");
+SymbolVecCache defaultsCache("defaults");
+CallResultCache callResultCache("call results");
+
+
+void printCacheStatistics(FILE* fp) {
+  fprintf(fp, "Resolution cache statistics\n");
+
+  ordersCache.stats.print(fp,     ordersCache.name);
+  genericsCache.stats.print(fp,   genericsCache.name);
+  coercionsCache.stats.print(fp,  coercionsCache.name);
+  promotionsCache.stats.print(fp, promotionsCache.name);
+  defaultsCache.stats.print(fp,   defaultsCache.name);
+  callResultCache.stats.print(fp, callResultCache.name);
+
+  fprintf(fp, "\n");
+}
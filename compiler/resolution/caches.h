@@ -21,6 +21,39 @@
 #define _CACHES_H_
 
 #include "baseAST.h"
+#include "callInfo.h"
+
+#include <cstdio>
+#include <vector>
+
+//
+// CacheStats: lookup counters kept by each of the caches below
+//
+//   hits, misses: number of checkCache calls that did/did not find a
+//                 matching entry
+//
+//   probes:       number of entries whose key was compared against
+//                 the query across all lookups
+//
+//   maxProbe:     longest bucket chain walked by a single lookup
+//
+//   maxEntries:   largest number of entries held at any one time
+//
+class CacheStats {
+ public:
+  CacheStats();
+
+  void             reset();
+  void             noteLookup(int probeLength, bool hit);
+  void             noteInsert(int numEntries);
+  void             print(FILE* fp, const char* name)            const;
+
+  unsigned long    hits;
+  unsigned long    misses;
+  unsigned long    probes;
+  int              maxProbe;
+  int              maxEntries;
+};
 
 //
 // SymbolMapCache: FnSymbol -> FnSymbol cache based on a SymbolMap
@@ -35,15 +68,32 @@
 //
 //   freeCache(cache): frees memory associated with cache
 //
+//   The entries are kept in a chained hash table keyed on old_fn
+//   combined with an order-independent hash of the map's key-value
+//   pairs, so a lookup only compares maps that are likely to match.
+//
 class SymbolMapCacheEntry {
  public:
-  SymbolMapCacheEntry(FnSymbol* ifn, SymbolMap* imap);
+  SymbolMapCacheEntry(FnSymbol*    ioldFn,
+                      FnSymbol*    ifn,
+                      SymbolMap*   imap,
+                      unsigned int ihash);
+  FnSymbol* oldFn;
   FnSymbol* fn;
   SymbolMap map;
+  unsigned int hash;
+  SymbolMapCacheEntry* next;
 };
-typedef Map<FnSymbol*,Vec<SymbolMapCacheEntry*>*> SymbolMapCache;
-typedef MapElem<FnSymbol*,Vec<SymbolMapCacheEntry*>*> SymbolMapCacheElem;
 
+class SymbolMapCache {
+ public:
+  SymbolMapCache(const char* iname);
+
+  const char*                        name;
+  std::vector<SymbolMapCacheEntry*>  buckets;
+  int                                numEntries;
+  CacheStats                         stats;
+};
 
 void addCache(SymbolMapCache& cache, FnSymbol* old, FnSymbol* fn, SymbolMap* map);
 FnSymbol* checkCache(SymbolMapCache& cache, FnSymbol* oldFn, SymbolMap* map);
@@ -60,17 +110,112 @@ void freeCache(SymbolMapCache& cache);
 //
 class SymbolVecCacheEntry {
  public:
-  SymbolVecCacheEntry(FnSymbol* fn, Vec<Symbol*>* ivec);
+  SymbolVecCacheEntry(FnSymbol*     ioldFn,
+                      FnSymbol*     ifn,
+                      Vec<Symbol*>* ivec,
+                      unsigned int  ihash);
+  FnSymbol* oldFn;
   FnSymbol* fn;
   Vec<Symbol*> vec;
+  unsigned int hash;
+  SymbolVecCacheEntry* next;
+};
+
+class SymbolVecCache {
+ public:
+  SymbolVecCache(const char* iname);
+
+  const char*                        name;
+  std::vector<SymbolVecCacheEntry*>  buckets;
+  int                                numEntries;
+  CacheStats                         stats;
 };
-typedef Map<FnSymbol*,Vec<SymbolVecCacheEntry*>*> SymbolVecCache;
-typedef MapElem<FnSymbol*,Vec<SymbolVecCacheEntry*>*> SymbolVecCacheElem;
 
 void addCache(SymbolVecCache& cache, FnSymbol* newFn, FnSymbol* oldFn, Vec<Symbol*>* vec);
 FnSymbol* checkCache(SymbolVecCache& cache, FnSymbol* fn, Vec<Symbol*>* vec);
 void freeCache(SymbolVecCache& cache);
 
+//
+// CallResultCache: (scope, name, actual signature) -> FnSymbol cache
+//
+//   Records the candidate chosen by gathering and disambiguation for
+//   a call so that other calls with the same shape can skip those
+//   steps.  A call's shape is the block that its visible functions
+//   are looked up from (the module named as in M.call, or else the
+//   block on the call's visibility chain where lookup starts to find
+//   functions) together with the module containing the call (which
+//   determines which private functions it can see), the function
+//   name, and for each actual its type, its name (for named
+//   arguments), whether it is a type and, for params, the param
+//   symbol itself.
+//
+//   addCache(cache, scope, info, fn, actualIdxToFormal): records that
+//                       calls like info in scope resolve to fn with
+//                       the given actual/formal alignment
+//
+//   checkCache(cache, scope, info, actualIdxToFormal): returns the
+//                       function recorded for calls like info in
+//                       scope, filling in the alignment, or NULL
+//
+//   invalidateCache(cache, name): discards every entry for calls to
+//                       name; called when a new function with that
+//                       name becomes visible
+//
+class CallResultCacheActual {
+ public:
+  CallResultCacheActual(Symbol* actual, const char* iname);
+
+  bool                   operator==(const CallResultCacheActual& other) const;
+
+  Type*                  type;
+  const char*            name;
+  Symbol*                param;
+  bool                   isType;
+};
+
+class CallResultCacheEntry {
+ public:
+  CallResultCacheEntry(BlockStmt*       iscope,
+                       ModuleSymbol*    imodule,
+                       CallInfo&        info,
+                       FnSymbol*        ifn,
+                       Vec<ArgSymbol*>& iactualIdxToFormal,
+                       unsigned int     ihash);
+
+  bool                   matches(BlockStmt*    iscope,
+                                 ModuleSymbol* imodule,
+                                 CallInfo&     info)                   const;
+
+  BlockStmt*             scope;
+  ModuleSymbol*          module;
+  bool                   explicitScope;
+  const char*            name;
+  bool                   methodTag;
+  std::vector<CallResultCacheActual> actuals;
+
+  FnSymbol*              fn;
+  Vec<ArgSymbol*>        actualIdxToFormal;
+  int                    epoch;
+  unsigned int           hash;
+  CallResultCacheEntry*  next;
+};
+
+class CallResultCache {
+ public:
+  CallResultCache(const char* iname);
+
+  const char*                         name;
+  std::vector<CallResultCacheEntry*>  buckets;
+  int                                 numEntries;
+  Map<const char*, int>               epochs;
+  CacheStats                          stats;
+};
+
+void addCache(CallResultCache& cache, BlockStmt* scope, CallInfo& info, FnSymbol* fn, Vec<ArgSymbol*>& actualIdxToFormal);
+FnSymbol* checkCache(CallResultCache& cache, BlockStmt* scope, CallInfo& info, Vec<ArgSymbol*>& actualIdxToFormal);
+void invalidateCache(CallResultCache& cache, const char* name);
+void freeCache(CallResultCache& cache);
+
 //
 // Caches to avoid creating multiple identical wrappers and
 // instantiating the same functions in the same ways
@@ -80,10 +225,14 @@ void freeCache(SymbolVecCache& cache);
 // when instantiating constructors and building up the default
 // wrappers for constructors.
 //
+// The lookup counters of each cache survive freeCache() so that
+// printCacheStatistics() can report them at the end of compilation.
+//
 extern SymbolMapCache ordersCache;
 extern SymbolMapCache genericsCache;
 extern SymbolMapCache coercionsCache;
 extern SymbolMapCache promotionsCache;
 extern SymbolVecCache defaultsCache;
+extern CallResultCache callResultCache;
 
 #endif
@@ -31,6 +31,7 @@
 #include "caches.h"
 #include "callInfo.h"
 #include "CForLoop.h"
+#include "compilerTrace.h"
 #include "driver.h"
 #include "expr.h"
 #include "ForLoop.h"
@@ -3405,6 +3406,49 @@ static int nVisibleFunctions = 0; // for incremental build
 static Map<BlockStmt*,BlockStmt*> visibilityBlockCache;
 static Vec<BlockStmt*> standardModuleSet;
 
+// set when getVisibleFunctions() followed a renaming 'use'; such
+// lookups are not recorded in callResultCache or visibleFunctionsCache
+// since a function added under the original name would not invalidate them
+static bool visibleFunctionsRenamed = false;
+
+//
+// visibleFunctionsCache records the result of a complete walk of
+// getVisibleFunctions() from a block, i.e. the functions with a given
+// name that are defined up the visibility chain or reached through the
+// transitive closure of its module uses.  As the result depends on the
+// privacy checks made against the calling module, entries for the same
+// block and name are chained by module.
+//
+// Entries are invalidated when buildVisibleFunctionMap() adds a function
+// with their name, which bumps visibleFunctionsEpochs for that name.
+//
+class VisibleFunctionsEntry {
+ public:
+  VisibleFunctionsEntry(ModuleSymbol* mod, int ep) :
+    module(mod), epoch(ep), nBlocks(0), next(NULL) { }
+
+  ModuleSymbol*          module;
+  int                    epoch;
+  Vec<FnSymbol*>         fns;
+  int                    nBlocks;  // blocks walked to compute 'fns'
+  VisibleFunctionsEntry* next;
+};
+
+class VisibleFunctionsClosure {
+ public:
+  Map<const char*,VisibleFunctionsEntry*> entries;
+  VisibleFunctionsClosure() { }
+};
+
+static Map<BlockStmt*,VisibleFunctionsClosure*> visibleFunctionsCache;
+static Map<const char*,int> visibleFunctionsEpochs;
+
+// for --report-visibility-stats
+static int nVisibleFunctionsLookups = 0;
+static int nVisibleFunctionsHits    = 0;
+static int nVisibilityBlocksWalked  = 0;
+static int nVisibilityBlocksSaved   = 0;
+
 //
 // return true if expr is a CondStmt with chpl__tryToken as its condition
 //
@@ -3484,6 +3528,10 @@ static void buildVisibleFunctionMap() {
         vfb->visibleFunctions.put(fn->name, fns);
       }
       fns->add(fn);
+
+      visibleFunctionsEpochs.put(fn->name,
+                                 visibleFunctionsEpochs.get(fn->name) + 1);
+      invalidateCache(callResultCache, fn->name);
     }
   }
   nVisibleFunctions = gFnSymbols.n;
@@ -3529,6 +3577,8 @@ getVisibleFunctions(BlockStmt* block,
   if (visited.set_in(block))
     return NULL;
 
+  nVisibilityBlocksWalked++;
+
   if (isModuleSymbol(block->parentSymbol))
     visited.set_add(block);
 
@@ -3566,6 +3616,7 @@ getVisibleFunctions(BlockStmt* block,
         canSkipThisBlock = false; // cannot skip if this block uses modules
         if (mod->isVisible(callOrigin)) {
           if (use->isARename(name)) {
+            visibleFunctionsRenamed = true;
             getVisibleFunctions(mod->block, use->getRename(name), visibleFns, visited, callOrigin);
           } else {
             getVisibleFunctions(mod->block, name, visibleFns, visited, callOrigin);
@@ -3594,6 +3645,97 @@ getVisibleFunctions(BlockStmt* block,
   return NULL;
 }
 
+//
+// Collect the functions called 'name' that are visible to 'call' from
+// 'block' using visibleFunctionsCache, walking the visibility chain
+// only if there is no current entry for 'block', 'name' and the module
+// of 'call'.
+//
+// 'block' is the visibility block of 'call' itself rather than the one
+// chosen by getMemoVisibilityBlock(): the walk must follow the same
+// visibilityBlockCache jumps as an uncached lookup would.
+//
+static void
+getCachedVisibleFunctions(BlockStmt*      block,
+                          const char*     name,
+                          Vec<FnSymbol*>& visibleFns,
+                          CallExpr*       call) {
+  ModuleSymbol*            module  = call->getModule();
+  int                      epoch   = visibleFunctionsEpochs.get(name);
+  VisibleFunctionsClosure* closure = visibleFunctionsCache.get(block);
+  VisibleFunctionsEntry*   entry   = NULL;
+
+  nVisibleFunctionsLookups++;
+
+  if (closure == NULL) {
+    closure = new VisibleFunctionsClosure();
+    visibleFunctionsCache.put(block, closure);
+  }
+
+  for (entry = closure->entries.get(name); entry; entry = entry->next) {
+    if (entry->module == module)
+      break;
+  }
+
+  if (entry != NULL && entry->epoch == epoch) {
+    nVisibleFunctionsHits++;
+    nVisibilityBlocksSaved += entry->nBlocks;
+    visibleFns.append(entry->fns);
+    return;
+  }
+
+  Vec<BlockStmt*> visited;
+  Vec<FnSymbol*>  fns;
+  int             nBlocks = nVisibilityBlocksWalked;
+
+  visibleFunctionsRenamed = false;
+  getVisibleFunctions(block, name, fns, visited, call);
+  nBlocks = nVisibilityBlocksWalked - nBlocks;
+
+  visibleFns.append(fns);
+
+  if (visibleFunctionsRenamed)
+    return;
+
+  if (entry == NULL) {
+    entry       = new VisibleFunctionsEntry(module, epoch);
+    entry->next = closure->entries.get(name);
+    closure->entries.put(name, entry);
+  }
+
+  entry->epoch   = epoch;
+  entry->fns.copy(fns);
+  entry->nBlocks = nBlocks;
+}
+
+static void freeVisibleFunctionsCache() {
+  Vec<VisibleFunctionsClosure*> closures;
+  visibleFunctionsCache.get_values(closures);
+  forv_Vec(VisibleFunctionsClosure, closure, closures) {
+    Vec<VisibleFunctionsEntry*> entries;
+    closure->entries.get_values(entries);
+    forv_Vec(VisibleFunctionsEntry, entry, entries) {
+      while (entry) {
+        VisibleFunctionsEntry* next = entry->next;
+        delete entry;
+        entry = next;
+      }
+    }
+    delete closure;
+  }
+  visibleFunctionsCache.clear();
+  visibleFunctionsEpochs.clear();
+}
+
+static void reportVisibilityStats() {
+  int nWalks = nVisibleFunctionsLookups - nVisibleFunctionsHits;
+
+  printf("VISIBLE FUNCTIONS: %d lookups, %d from cache, %d walked\n",
+         nVisibleFunctionsLookups, nVisibleFunctionsHits, nWalks);
+  printf("VISIBLE FUNCTIONS: %d blocks visited, %d block visits avoided\n",
+         nVisibilityBlocksWalked, nVisibilityBlocksSaved);
+}
+
 // Ensure 'parent' is the block before which we want to do the capturing.
 static void verifyTaskFnCall(BlockStmt* parent, CallExpr* call) {
   if (call->isNamed("coforall_fn") || call->isNamed("on_fn")) {
@@ -4222,41 +4364,88 @@ FnSymbol* tryResolveCall(CallExpr* call) {
 }
 
 
-// if checkonly is provided, don't print any errors; just check
-// to see if the particular function could be resolved.
-// returns the result of resolving - or NULL if we couldn't do it.
-// If checkonly is set, NULL can be returned - otherwise that would
-// be a fatal error.
-FnSymbol* resolveNormalCall(CallExpr* call, bool checkonly) {
+//
+// Calls that are being explained, that are already resolved (task
+// function calls), or that are partial (method calls without parens)
+// are always resolved in full.
+//
+static bool isMemoizableCall(CallExpr* call) {
+  return fNoMemoizeResolution == false  &&
+         call->isResolved()   == NULL   &&
+         call->partialTag     == false  &&
+         call->id             != explainCallID &&
+         (explainCallLine == 0 || !explainCallMatch(call));
+}
 
-  if( call->id == breakOnResolveID ) {
-    printf("breaking on resolve call:\n");
-    print_view(call);
-    gdbShouldBreakHere();
-  }
 
-  temporaryInitializerFixup(call);
+//
+// Return the first block on the visibility chain of 'call' that
+// defines functions or uses modules.  The blocks skipped on the way
+// contribute no functions, so calls in any of them see the same
+// visible functions and can share entries in callResultCache.
+//
+// Like getVisibleFunctions(), follow visibilityBlockCache where it
+// has an entry; if the chain runs into a block that is no longer in
+// the tree (e.g. the instantiation point of a folded conditional),
+// return NULL and let the call be resolved in full.
+//
+static BlockStmt* getMemoVisibilityBlock(CallExpr* call) {
+  BlockStmt* block = getVisibilityBlock(call);
+
+  while (block                           != NULL              &&
+         block                           != rootModule->block &&
+         block->modUses                  == NULL              &&
+         visibleFunctionMap.get(block)   == NULL              &&
+         standardModuleSet.set_in(block) == NULL) {
+    if (BlockStmt* next = visibilityBlockCache.get(block))
+      block = next;
+    else if (block->parentExpr != NULL || block->parentSymbol != NULL)
+      block = getVisibilityBlock(block);
+    else
+      block = NULL;
+  }
 
-  resolveDefaultGenericType(call);
+  return block;
+}
 
-  CallInfo info(call, checkonly);
 
-  // Return early if creating the call info would have been an error.
-  if( checkonly && info.badcall ) return NULL;
+static ResolutionCandidate* lookupCallResult(BlockStmt* scope,
+                                             CallInfo&  info) {
+  ResolutionCandidate* retval = new ResolutionCandidate(NULL);
+  FnSymbol*            fn     = checkCache(callResultCache,
+                                           scope,
+                                           info,
+                                           retval->actualIdxToFormal);
 
-  Vec<FnSymbol*> visibleFns; // visible functions
+  // The recorded function may have been pruned since it was chosen
+  if (fn != NULL && fn->defPoint != NULL && fn->defPoint->parentSymbol) {
+    retval->fn = fn;
 
-  //
-  // update visible function map as necessary
-  //
-  if (gFnSymbols.n != nVisibleFunctions) {
-    buildVisibleFunctionMap();
+  } else {
+    delete retval;
+    retval = NULL;
   }
 
+  return retval;
+}
+
+
+//
+// Find the visible functions for 'call', filter them down to the
+// candidates and pick the best ref and value candidates.
+//
+static void
+findBestCandidates(CallExpr*                  call,
+                   CallInfo&                  info,
+                   Vec<FnSymbol*>&            visibleFns,
+                   Vec<ResolutionCandidate*>& candidates,
+                   ResolutionCandidate*&      bestRef,
+                   ResolutionCandidate*&      bestValue) {
+  visibleFunctionsRenamed = false;
+
   if (!call->isResolved()) {
     if (!info.scope) {
-      Vec<BlockStmt*> visited;
-      getVisibleFunctions(getVisibilityBlock(call), info.name, visibleFns, visited, call);
+      getCachedVisibleFunctions(getVisibilityBlock(call), info.name, visibleFns, call);
     } else {
       if (VisibleFunctionBlock* vfb = visibleFunctionMap.get(info.scope)) {
         if (Vec<FnSymbol*>* fns = vfb->visibleFunctions.get(info.name)) {
@@ -4284,7 +4473,6 @@ FnSymbol* resolveNormalCall(CallExpr* call, bool checkonly) {
     }
   }
 
-  Vec<ResolutionCandidate*> candidates;
   gatherCandidates(candidates, visibleFns, info);
 
   if ((explainCallLine && explainCallMatch(info.call)) ||
@@ -4310,8 +4498,8 @@ FnSymbol* resolveNormalCall(CallExpr* call, bool checkonly) {
      info.call->id == explainCallID);
   DisambiguationContext DC(&info.actuals, scope, explain);
 
-  ResolutionCandidate* bestRef = disambiguateByMatch(candidates, DC, FIND_REF);
-  ResolutionCandidate* bestValue = disambiguateByMatch(candidates, DC, FIND_NOT_REF);
+  bestRef   = disambiguateByMatch(candidates, DC, FIND_REF);
+  bestValue = disambiguateByMatch(candidates, DC, FIND_NOT_REF);
 
   // If one requires more promotion than the other, this is not a ref-pair.
   if (bestRef && bestValue && isBetterMatch(bestRef, bestValue, DC, true)) {
@@ -4320,6 +4508,81 @@ FnSymbol* resolveNormalCall(CallExpr* call, bool checkonly) {
   if (bestRef && bestValue && isBetterMatch(bestValue, bestRef, DC, true)) {
     bestRef = NULL; // Don't consider the ref function.
   }
+}
+
+
+static TraceCounter normalCallsResolved("normal calls resolved");
+static TraceCounter normalCallsReused("normal call results reused");
+
+// if checkonly is provided, don't print any errors; just check
+// to see if the particular function could be resolved.
+// returns the result of resolving - or NULL if we couldn't do it.
+// If checkonly is set, NULL can be returned - otherwise that would
+// be a fatal error.
+FnSymbol* resolveNormalCall(CallExpr* call, bool checkonly) {
+
+  if( call->id == breakOnResolveID ) {
+    printf("breaking on resolve call:\n");
+    print_view(call);
+    gdbShouldBreakHere();
+  }
+
+  temporaryInitializerFixup(call);
+
+  resolveDefaultGenericType(call);
+
+  CallInfo info(call, checkonly);
+
+  // Return early if creating the call info would have been an error.
+  if( checkonly && info.badcall ) return NULL;
+
+  TraceRegion region("resolveNormalCall", info.name);
+
+  normalCallsResolved.Add();
+
+  Vec<FnSymbol*>            visibleFns; // visible functions
+  Vec<ResolutionCandidate*> candidates;
+  ResolutionCandidate*      bestRef   = NULL;
+  ResolutionCandidate*      bestValue = NULL;
+  BlockStmt*                memoScope = NULL;
+
+  //
+  // update visible function map as necessary
+  //
+  if (gFnSymbols.n != nVisibleFunctions) {
+    buildVisibleFunctionMap();
+  }
+
+  //
+  // A call with the same shape as one resolved earlier reuses that
+  // result rather than gathering and disambiguating candidates again.
+  //
+  if (isMemoizableCall(call)) {
+    memoScope = (info.scope) ? info.scope : getMemoVisibilityBlock(call);
+
+    if (memoScope != NULL)
+      bestRef = lookupCallResult(memoScope, info);
+
+    if (bestRef != NULL) {
+      candidates.add(bestRef);
+      normalCallsReused.Add();
+    }
+  }
+
+  if (bestRef == NULL) {
+    findBestCandidates(call, info, visibleFns, candidates, bestRef, bestValue);
+
+    // Ref/value pairs are not recorded; they are resolved in full
+    if (memoScope != NULL && visibleFunctionsRenamed == false) {
+      if (bestRef != NULL && bestValue == NULL)
+        addCache(callResultCache, memoScope, info,
+                 bestRef->fn, bestRef->actualIdxToFormal);
+
+      else if (bestRef == NULL && bestValue != NULL)
+        addCache(callResultCache, memoScope, info,
+                 bestValue->fn, bestValue->actualIdxToFormal);
+    }
+  }
 
   ResolutionCandidate* best = bestRef;
   if (!best) best = bestValue;
@@ -8840,6 +9103,22 @@ computeStandardModuleSet() {
 }
 
 
+//
+// Resolution runs on a single thread.  Resolving a function body is not
+// independent of resolving any other: it instantiates generics and
+// builds wrappers into the shared tree (instantiate() inserts the new
+// function at the instantiation point), every new AST node is appended
+// to the global gVecs and takes the next id, and the results are shared
+// through the global caches in caches.h, visibleFunctionMap and
+// visibleFunctionsCache, which is what makes the caches effective.
+// Function ids and cnames are also assigned in resolution order, so the
+// generated code depends on it.
+//
+// Resolving bodies concurrently would need per-thread node allocation
+// and ids, a deterministic merge of instantiations, and locking in
+// the caches.  Until then, compile-time improvements come from avoiding
+// repeated work in the serial resolver.
+//
 void
 resolve() {
   parseExplainFlag(fExplainCall, &explainCallLine, &explainCallModule);
@@ -8919,6 +9198,7 @@ resolve() {
   freeCache(genericsCache);
   freeCache(coercionsCache);
   freeCache(promotionsCache);
+  freeCache(callResultCache);
   freeCache(capturedValues);
 
   Vec<VisibleFunctionBlock*> vfbs;
@@ -8933,6 +9213,10 @@ resolve() {
   }
   visibleFunctionMap.clear();
   visibilityBlockCache.clear();
+  freeVisibleFunctionsCache();
+
+  if (fReportVisibilityStats)
+    reportVisibilityStats();
   clearPartialCopyFnMap();
 
   forv_Vec(BlockStmt, stmt, gBlockStmts) {
@@ -533,20 +533,23 @@ instantiateSignature(FnSymbol* fn, SymbolMap& subs, CallExpr* call) {
   // instantiate function
   //
   
-  SymbolMap map;
+  SymbolMap copyMap;
   
   if (newType) {
-    map.put(fn->retType->symbol, newType->symbol);
+    copyMap.put(fn->retType->symbol, newType->symbol);
   }
   
-  FnSymbol* newFn = fn->partialCopy(&map);
+  // The body is copied later by instantiateBody(), and only if this
+  // instantiation is chosen; partialCopy() keeps the map for that.
+  FnSymbol*  newFn = fn->partialCopy(&copyMap);
+  SymbolMap& map   = getPartialCopyInfo(newFn)->partialCopyMap;
 
   addCache(genericsCache, root, newFn, &all_subs);
 
   newFn->removeFlag(FLAG_GENERIC);
   newFn->addFlag(FLAG_INVISIBLE_FN);
   newFn->instantiatedFrom = fn;
-  newFn->substitutions.map_union(all_subs);
+  newFn->substitutions.move(all_subs);
 
   if (call) {
     newFn->instantiationPoint = getVisibilityBlock(call);
@@ -635,7 +638,7 @@ instantiateSignature(FnSymbol* fn, SymbolMap& subs, CallExpr* call) {
     //
     // where clause evaluates to false so cache gVoid as a function
     //
-    replaceCache(genericsCache, root, (FnSymbol*)gVoid, &all_subs);
+    replaceCache(genericsCache, root, (FnSymbol*)gVoid, &newFn->substitutions);
     return NULL;
   }
 
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2004-2016 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _chpl_comm_aggregate_h_
+#define _chpl_comm_aggregate_h_
+
+#include "chpltypes.h"
+#include "chpl-comm.h"
+
+//
+// Aggregation of fine-grained remote PUTs.
+//
+// When compiled with --aggregate-remote-ops, the compiler gives each
+// eligible order independent loop (e.g. the body of a forall) an
+// aggregator.  The remote PUTs the loop makes are buffered per destination
+// node and sent with a single indexed PUT when a buffer fills and when the
+// loop ends.
+//
+// The aggregator is the task's active aggregator until it is flushed.  A
+// GET or unaggregated PUT by the task that may overlap a buffered PUT first
+// sends the buffer for that node, so a task always reads its own writes and
+// its PUTs complete in order.  All the buffers are sent before the task
+// runs an 'on' statement remotely or starts another aggregator.
+//
+// An aggregator belongs to one task, so the buffers need no locking.
+//
+
+// Is aggregation enabled? (set at compile time)
+extern const int CHPL_AGGREGATE_REMOTE_OPS;
+
+static inline
+int chpl_comm_aggregate_enabled(void)
+{
+  return CHPL_AGGREGATE_REMOTE_OPS;
+}
+
+struct chpl_comm_aggregate_buf_s;
+
+typedef struct chpl_comm_aggregator_s {
+  // one buffer per node, allocated on the first PUT to that node
+  struct chpl_comm_aggregate_buf_s** bufs;
+
+  // the task's active aggregator when this one was started
+  struct chpl_comm_aggregator_s*     prev;
+} chpl_comm_aggregator_t;
+
+// Make agg the task's active aggregator.
+void chpl_comm_aggregate_init(chpl_comm_aggregator_t* agg);
+
+// Buffer a PUT to a remote node.
+void chpl_comm_aggregate_put(chpl_comm_aggregator_t* agg,
+                             void* addr, c_nodeid_t node, void* raddr,
+                             size_t size, int32_t typeIndex,
+                             int ln, int32_t fn);
+
+// Send the buffered PUTs to node if any of them may overlap the given
+// remote range.
+void chpl_comm_aggregate_fence(chpl_comm_aggregator_t* agg,
+                               c_nodeid_t node, void* raddr, size_t size,
+                               int ln, int32_t fn);
+
+// Send the buffered PUTs of the task's active aggregator to node if any of
+// them may overlap the given remote range.
+void chpl_comm_aggregate_fence_task(c_nodeid_t node, void* raddr, size_t size,
+                                    int ln, int32_t fn);
+
+// Send all the buffered PUTs of the task's active aggregator.
+void chpl_comm_aggregate_release(int ln, int32_t fn);
+
+// Send all buffered PUTs, release the buffers and deactivate agg.
+void chpl_comm_aggregate_flush(chpl_comm_aggregator_t* agg,
+                               int ln, int32_t fn);
+
+#endif
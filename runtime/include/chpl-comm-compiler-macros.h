@@ -29,6 +29,7 @@
 
 #include "chpl-prefetch.h" // for chpl_prefetch
 #include "chpl-cache.h" // chpl_cache_enabled, chpl_cache_comm_get etc
+#include "chpl-comm-aggregate.h" // chpl_comm_aggregate_put etc
 
 // Don't warn about chpl_comm_get e.g. in this file.
 #include "chpl-comm-no-warning-macros.h"
@@ -45,6 +46,10 @@ void chpl_gen_comm_get(void *addr, c_nodeid_t node, void* raddr,
                        size_t size, int32_t typeIndex,
                        int ln, int32_t fn)
 {
+  // Read this task's own aggregated PUTs
+  if (chpl_comm_aggregate_enabled() && chpl_nodeID != node)
+    chpl_comm_aggregate_fence_task(node, raddr, size, ln, fn);
+
   if (chpl_nodeID == node) {
     chpl_memcpy(addr, raddr, size);
 #ifdef HAS_CHPL_CACHE_FNS
@@ -92,6 +97,10 @@ void chpl_gen_comm_put(void* addr, c_nodeid_t node, void* raddr,
                        size_t size, int32_t typeIndex,
                        int ln, int32_t fn)
 {
+  // Keep this task's PUTs in order
+  if (chpl_comm_aggregate_enabled() && chpl_nodeID != node)
+    chpl_comm_aggregate_fence_task(node, raddr, size, ln, fn);
+
   if (chpl_nodeID == node) {
     chpl_memcpy(raddr, addr, size);
 #ifdef HAS_CHPL_CACHE_FNS
@@ -107,6 +116,27 @@ void chpl_gen_comm_put(void* addr, c_nodeid_t node, void* raddr,
   }
 }
 
+//
+// A PUT in a loop compiled with --aggregate-remote-ops.  The remote data
+// cache, when enabled, already buffers PUTs, so it takes precedence.
+//
+static inline
+void chpl_gen_comm_put_aggregate(chpl_comm_aggregator_t* agg,
+                                 void* addr, c_nodeid_t node, void* raddr,
+                                 size_t size, int32_t typeIndex,
+                                 int ln, int32_t fn)
+{
+  if (chpl_nodeID == node) {
+    chpl_memcpy(raddr, addr, size);
+#ifdef HAS_CHPL_CACHE_FNS
+  } else if( chpl_cache_enabled() ) {
+    chpl_cache_comm_put(addr, node, raddr, size, typeIndex, ln, fn);
+#endif
+  } else {
+    chpl_comm_aggregate_put(agg, addr, node, raddr, size, typeIndex, ln, fn);
+  }
+}
+
 static inline
 void chpl_gen_comm_get_strd(void *addr, void *dststr, c_nodeid_t node, void *raddr,
                        void *srcstr, void *count, int32_t strlevels, 
@@ -350,6 +350,16 @@ void  chpl_comm_get_strd(void* dstaddr, size_t* dststrides, c_nodeid_t srcnode,
                      int32_t stridelevels, size_t elemSize, int32_t typeIndex, 
                      int ln, int32_t fn);
 
+//
+// put count values of elemSize bytes each, stored contiguously at addr, to
+// the addresses raddrs[0..count-1] on node.  The destinations must not
+// overlap.  Used to send the buffers of chpl-comm-aggregate.c.
+// When comm=gasnet, this function ends up calling gasnet_puti_bulk().
+//
+void  chpl_comm_put_indexed(void* addr, c_nodeid_t node, void** raddrs,
+                            size_t count, size_t elemSize, int32_t typeIndex,
+                            int ln, int32_t fn);
+
 //
 // Get a local copy of a wide string.
 //
@@ -26,6 +26,9 @@
 // The type for task private data
 typedef struct {
   chpl_comm_taskPrvData_t comm_data;
+
+  // the task's active PUT aggregator, if any; see chpl-comm-aggregate.h
+  struct chpl_comm_aggregator_s* comm_aggregator;
 } chpl_task_prvData_t;
 
 #endif
@@ -67,6 +67,7 @@ extern const char* CHPL_AUX_FILESYS;
 extern const char* CHPL_UNWIND;
 extern const int CHPL_STACK_CHECKS;
 extern const int CHPL_CACHE_REMOTE;
+extern const int CHPL_AGGREGATE_REMOTE_OPS;
 
 // Sorted lookup table of filenames used with insertLineNumbers for error
 // messages and logging. Defined in chpl_compilation_config.c (needed by launchers)
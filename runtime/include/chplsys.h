@@ -34,6 +34,13 @@ int chpl_getNumLogicalCpus(chpl_bool accessible_only);
 
 void chpl_moveToLastCPU(void);
 
+//
+// NUMA domains are numbered from 0 to chpl_getNumNumaDomains()-1,
+// counting only the ones with CPUs we can run on.
+//
+int chpl_getNumNumaDomains(void);
+void chpl_moveToNumaDomain(int domain);
+
 //
 // returns the name of a locale via uname -n or the like
 //
@@ -0,0 +1,251 @@
+/*
+ * Copyright 2004-2016 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// Aggregation of fine-grained remote PUTs; see chpl-comm-aggregate.h.
+//
+// Each destination node has a buffer of the remote addresses and the
+// values of the PUTs to it.  All the values in a buffer have the same
+// size, so the buffer can be sent with one chpl_comm_put_indexed().  PUTs
+// of larger values are not buffered.
+//
+// A small bit filter, indexed by the words the buffered PUTs write, tells
+// whether a GET or PUT may overlap a buffered PUT.  If so, the buffer is
+// sent first: a task must read its own writes, and the PUTs in a buffer
+// must not overlap.
+//
+
+#include "chplrt.h"
+
+#include "chpl-comm.h"
+#include "chpl-comm-aggregate.h"
+#include "chpl-comm-no-warning-macros.h" // No warnings for chpl_comm_put
+#include "chpl-linefile-support.h"
+#include "chpl-mem.h"
+#include "chpl-mem-desc.h"
+#include "chpl-tasks.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define AGG_BUF_BYTES      4096
+#define AGG_MAX_ELEM_SIZE  64
+#define AGG_MAX_ENTRIES    (AGG_BUF_BYTES / sizeof(int64_t))
+#define AGG_FILTER_BITS    4096
+
+typedef struct chpl_comm_aggregate_buf_s {
+  size_t        elemSize;             // size of each buffered value
+  int32_t       typeIndex;            // type of the first buffered value
+  size_t        count;                // number of buffered PUTs
+  void*         raddrs[AGG_MAX_ENTRIES];
+  uint64_t      filter[AGG_FILTER_BITS / 64];
+  unsigned char data[AGG_BUF_BYTES];
+} chpl_comm_aggregate_buf_t;
+
+static inline
+size_t filterBit(uintptr_t word)
+{
+  return (size_t) (word & (AGG_FILTER_BITS - 1));
+}
+
+static
+void filterAdd(chpl_comm_aggregate_buf_t* buf, void* raddr, size_t size)
+{
+  uintptr_t first = ((uintptr_t) raddr) >> 3;
+  uintptr_t last  = ((uintptr_t) raddr + size - 1) >> 3;
+  uintptr_t word;
+
+  for (word = first; word <= last; word++) {
+    size_t bit = filterBit(word);
+
+    buf->filter[bit / 64] |= ((uint64_t) 1) << (bit % 64);
+  }
+}
+
+static
+chpl_bool filterHit(chpl_comm_aggregate_buf_t* buf, void* raddr, size_t size)
+{
+  uintptr_t first = ((uintptr_t) raddr) >> 3;
+  uintptr_t last  = ((uintptr_t) raddr + size - 1) >> 3;
+  uintptr_t word;
+
+  // a range this large covers every bit
+  if (last - first >= AGG_FILTER_BITS)
+    return true;
+
+  for (word = first; word <= last; word++) {
+    size_t bit = filterBit(word);
+
+    if (buf->filter[bit / 64] & (((uint64_t) 1) << (bit % 64)))
+      return true;
+  }
+
+  return false;
+}
+
+static
+void sendBuf(chpl_comm_aggregate_buf_t* buf, c_nodeid_t node,
+             int ln, int32_t fn)
+{
+  if (buf->count == 0)
+    return;
+
+  chpl_comm_put_indexed(buf->data, node, buf->raddrs, buf->count,
+                        buf->elemSize, buf->typeIndex, ln, fn);
+
+  buf->count = 0;
+  memset(buf->filter, 0, sizeof(buf->filter));
+}
+
+static
+chpl_comm_aggregate_buf_t* getBuf(chpl_comm_aggregator_t* agg,
+                                  c_nodeid_t node, int ln, int32_t fn)
+{
+  if (agg->bufs == NULL)
+    agg->bufs = chpl_mem_allocManyZero(chpl_numNodes,
+                                       sizeof(chpl_comm_aggregate_buf_t*),
+                                       CHPL_RT_MD_COMM_AGGREGATE_BUF,
+                                       ln, fn);
+
+  if (agg->bufs[node] == NULL)
+    agg->bufs[node] = chpl_mem_allocManyZero(1,
+                                             sizeof(chpl_comm_aggregate_buf_t),
+                                             CHPL_RT_MD_COMM_AGGREGATE_BUF,
+                                             ln, fn);
+
+  return agg->bufs[node];
+}
+
+static
+void sendAll(chpl_comm_aggregator_t* agg, int ln, int32_t fn)
+{
+  c_nodeid_t node;
+
+  if (agg->bufs == NULL)
+    return;
+
+  for (node = 0; node < chpl_numNodes; node++) {
+    if (agg->bufs[node] != NULL)
+      sendBuf(agg->bufs[node], node, ln, fn);
+  }
+}
+
+void chpl_comm_aggregate_init(chpl_comm_aggregator_t* agg)
+{
+  chpl_task_prvData_t* prvData = chpl_task_getPrvData();
+
+  agg->bufs = NULL;
+  agg->prev = prvData->comm_aggregator;
+
+  // The enclosing aggregator's PUTs must not be reordered with ours
+  if (agg->prev != NULL)
+    sendAll(agg->prev, 0, CHPL_FILE_IDX_INTERNAL);
+
+  prvData->comm_aggregator = agg;
+}
+
+void chpl_comm_aggregate_put(chpl_comm_aggregator_t* agg,
+                             void* addr, c_nodeid_t node, void* raddr,
+                             size_t size, int32_t typeIndex,
+                             int ln, int32_t fn)
+{
+  chpl_comm_aggregate_buf_t* buf;
+
+  if (size == 0)
+    return;
+
+  if (size > AGG_MAX_ELEM_SIZE) {
+    chpl_comm_aggregate_fence(agg, node, raddr, size, ln, fn);
+    chpl_comm_put(addr, node, raddr, size, typeIndex, ln, fn);
+    return;
+  }
+
+  buf = getBuf(agg, node, ln, fn);
+
+  if (buf->count > 0 &&
+      (buf->elemSize != size || filterHit(buf, raddr, size)))
+    sendBuf(buf, node, ln, fn);
+
+  if (buf->count == 0) {
+    buf->elemSize  = size;
+    buf->typeIndex = typeIndex;
+  }
+
+  memcpy(buf->data + buf->count * size, addr, size);
+  buf->raddrs[buf->count] = raddr;
+  buf->count++;
+
+  filterAdd(buf, raddr, size);
+
+  if (buf->count == AGG_MAX_ENTRIES || (buf->count + 1) * size > AGG_BUF_BYTES)
+    sendBuf(buf, node, ln, fn);
+}
+
+void chpl_comm_aggregate_fence(chpl_comm_aggregator_t* agg,
+                               c_nodeid_t node, void* raddr, size_t size,
+                               int ln, int32_t fn)
+{
+  chpl_comm_aggregate_buf_t* buf;
+
+  if (agg->bufs == NULL || size == 0)
+    return;
+
+  buf = agg->bufs[node];
+
+  if (buf != NULL && buf->count > 0 && filterHit(buf, raddr, size))
+    sendBuf(buf, node, ln, fn);
+}
+
+void chpl_comm_aggregate_fence_task(c_nodeid_t node, void* raddr, size_t size,
+                                    int ln, int32_t fn)
+{
+  chpl_comm_aggregator_t* agg = chpl_task_getPrvData()->comm_aggregator;
+
+  if (agg != NULL)
+    chpl_comm_aggregate_fence(agg, node, raddr, size, ln, fn);
+}
+
+void chpl_comm_aggregate_release(int ln, int32_t fn)
+{
+  chpl_comm_aggregator_t* agg = chpl_task_getPrvData()->comm_aggregator;
+
+  if (agg != NULL)
+    sendAll(agg, ln, fn);
+}
+
+void chpl_comm_aggregate_flush(chpl_comm_aggregator_t* agg,
+                               int ln, int32_t fn)
+{
+  c_nodeid_t node;
+
+  chpl_task_getPrvData()->comm_aggregator = agg->prev;
+
+  if (agg->bufs == NULL)
+    return;
+
+  sendAll(agg, ln, fn);
+
+  for (node = 0; node < chpl_numNodes; node++) {
+    if (agg->bufs[node] != NULL)
+      chpl_mem_free(agg->bufs[node], ln, fn);
+  }
+
+  chpl_mem_free(agg->bufs, ln, fn);
+  agg->bufs = NULL;
+}
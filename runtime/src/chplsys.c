@@ -44,6 +44,8 @@
 
 #include <signal.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
 #include <sys/utsname.h>
@@ -651,6 +653,130 @@ void chpl_moveToLastCPU(void) {
 }
 
 
+#if defined __linux__
+//
+// The NUMA domains we can run on and their CPUs, from the lists in
+// /sys/devices/system/node.  Domains without CPUs we can run on are
+// left out, so the numbering here may differ from the kernel's.
+//
+#define MAX_NUMA_DOMAINS 64
+
+static int numNumaDomains = 0;
+static cpu_set_t numaDomainCpus[MAX_NUMA_DOMAINS];
+static cpu_set_t accessibleCpus;
+static pthread_once_t numaInfoOnce = PTHREAD_ONCE_INIT;
+
+//
+// Read a list such as "0-3,8-11" from the given file into a CPU set.
+// Returns false if the file cannot be read.
+//
+static chpl_bool readCpuList(const char* fname, cpu_set_t* set) {
+  FILE* f;
+  char buf[1024];
+  char* p;
+
+  CPU_ZERO(set);
+
+  if ((f = fopen(fname, "r")) == NULL)
+    return false;
+  if (fgets(buf, sizeof(buf), f) == NULL)
+    buf[0] = '\0';
+  fclose(f);
+
+  for (p = buf; *p != '\0' && *p != '\n'; ) {
+    char* end;
+    long lo, hi, i;
+
+    lo = hi = strtol(p, &end, 10);
+    if (end == p)
+      break;
+    if (*end == '-') {
+      p = end + 1;
+      hi = strtol(p, &end, 10);
+    }
+    for (i = lo; i <= hi && i < CPU_SETSIZE; i++)
+      CPU_SET(i, set);
+    p = (*end == ',') ? end + 1 : end;
+  }
+
+  return true;
+}
+
+static void getNumaInfo(void) {
+  cpu_set_t nodes;
+  int node;
+
+  if (sched_getaffinity(getpid(), sizeof(accessibleCpus), &accessibleCpus)
+      != 0)
+    chpl_internal_error("sched_getaffinity() failed");
+
+  if (readCpuList("/sys/devices/system/node/online", &nodes)) {
+    for (node = 0;
+         node < CPU_SETSIZE && numNumaDomains < MAX_NUMA_DOMAINS;
+         node++) {
+      char fname[100];
+      cpu_set_t* cpus = &numaDomainCpus[numNumaDomains];
+
+      if (!CPU_ISSET(node, &nodes))
+        continue;
+      snprintf(fname, sizeof(fname),
+               "/sys/devices/system/node/node%d/cpulist", node);
+      if (readCpuList(fname, cpus)) {
+        CPU_AND(cpus, cpus, &accessibleCpus);
+        if (CPU_COUNT(cpus) > 0)
+          numNumaDomains++;
+      }
+    }
+  }
+
+  if (numNumaDomains == 0) {
+    numaDomainCpus[0] = accessibleCpus;
+    numNumaDomains = 1;
+  }
+}
+#endif
+
+
+int chpl_getNumNumaDomains(void) {
+  //
+  // We only know how to find NUMA domains on Linux.  Elsewhere the
+  // whole node is treated as one.
+  //
+#if defined __linux__
+  pthread_once(&numaInfoOnce, getNumaInfo);
+  return numNumaDomains;
+#else
+  return 1;
+#endif
+}
+
+
+//
+// Restrict the calling thread to the CPUs of the given NUMA domain, or
+// if the domain is not one of ours (c_sublocid_any, e.g.), let it run
+// on any CPU the process can use again.  Memory the thread touches
+// first is then usually placed in that domain.
+//
+void chpl_moveToNumaDomain(int domain) {
+  //
+  // This is currently a no-op except on Linux.
+  //
+#if defined __linux__
+  cpu_set_t* mask;
+
+  pthread_once(&numaInfoOnce, getNumaInfo);
+
+  mask = (domain >= 0 && domain < numNumaDomains)
+         ? &numaDomainCpus[domain]
+         : &accessibleCpus;
+  if (pthread_setaffinity_np(pthread_self(), sizeof(*mask), mask) != 0)
+    chpl_internal_error("pthread_setaffinity_np() failed");
+#endif
+
+  return;
+}
+
+
 // Using a static buffer is a bad idea from the standpoint of thread-safety.
 // However, since the node name is not expected to change it is OK to
 // initialize it once and share the singleton string.
@@ -36,6 +36,7 @@
 #include "error.h"
 #include "chpl-mem-desc.h"
 #include "chpl-cache.h" // to call chpl_cache_init()
+#include "chpl-comm-aggregate.h" // chpl_comm_aggregate_release
 
 // Don't get warning macros for chpl_comm_get etc
 #include "chpl-comm-no-warning-macros.h"
@@ -1422,6 +1423,30 @@ void  chpl_comm_put_strd(void* dstaddr, size_t* dststrides, c_nodeid_t dstnode_i
   gasnet_puts_bulk(dstnode, dstaddr, dststr, srcaddr, srcstr, cnt, strlvls); 
 }
 
+//
+// This is an adapter from the put aggregation buffers to GASNet's
+// gasnet_puti_bulk(), which sends all of the values in one operation where
+// the conduit supports it.
+//
+void  chpl_comm_put_indexed(void* addr, c_nodeid_t node_id, void** raddrs,
+                            size_t count, size_t elemSize, int32_t typeIndex,
+                            int ln, int32_t fn) {
+  const gasnet_node_t node = (gasnet_node_t)node_id;
+
+  if (chpl_verbose_comm && !chpl_comm_no_debug_private)
+    printf("%d: %s:%d: remote indexed put to %d. count:%ld elemSize:%ld\n",
+           chpl_nodeID, chpl_lookupFilename(fn), ln, node,
+           (long)count, (long)elemSize);
+  if (chpl_comm_diagnostics && !chpl_comm_no_debug_private) {
+    chpl_sync_lock(&chpl_comm_diagnostics_sync);
+    chpl_comm_commDiagnostics.put++;
+    chpl_sync_unlock(&chpl_comm_diagnostics_sync);
+  }
+
+  // TODO -- handle indexed put for non-registered memory
+  gasnet_puti_bulk(node, count, raddrs, elemSize, 1, &addr, count * elemSize);
+}
+
 static inline
 void  execute_on_common(c_nodeid_t node, c_sublocid_t subloc,
                         chpl_fn_int_t fid,
@@ -1437,6 +1462,10 @@ void  execute_on_common(c_nodeid_t node, c_sublocid_t subloc,
 
   chpl_bool serial_state = chpl_task_getSerial();
 
+  // The body may read what this task's aggregated PUTs write
+  if (chpl_comm_aggregate_enabled())
+    chpl_comm_aggregate_release(0, CHPL_FILE_IDX_INTERNAL);
+
   if (blocking)
     init_done_obj(&done, 1);
 
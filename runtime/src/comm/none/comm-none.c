@@ -162,6 +162,17 @@ void  chpl_comm_get(void* addr, c_nodeid_t node, void* raddr,
   memmove(addr, raddr, size);
 }
 
+void  chpl_comm_put_indexed(void* addr, c_nodeid_t node, void** raddrs,
+                            size_t count, size_t elemSize, int32_t typeIndex,
+                            int ln, int32_t fn) {
+  size_t i;
+
+  assert(node==0);
+
+  for (i=0; i<count; i++)
+    memmove(raddrs[i], (int8_t*)addr + i*elemSize, elemSize);
+}
+
 void  chpl_comm_put_strd(void* dstaddr_arg, size_t* dststrides, c_nodeid_t dstnode,
                          void* srcaddr_arg, size_t* srcstrides, size_t* count,
                          int32_t stridelevels, size_t elemSize, int32_t typeIndex,
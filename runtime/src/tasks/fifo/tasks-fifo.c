@@ -20,9 +20,26 @@
 //
 // FIFO implementation of Chapel tasking interface
 //
+// Each thread that creates tasks puts them on its own deque (a
+// Chase-Lev work-stealing deque).  A thread looking for work takes the
+// newest task from its own deque, and if that is empty, steals the
+// oldest task from the deque of another thread, starting at a random
+// one.  A task on a task list can also be run by the task that owns
+// the list, in chpl_task_executeTasksInList(), so a task is only run
+// by the thread that first claims it and is freed when both its deque
+// and its task list are done with it.
+//
+// In the numa locale model each sublocale is a NUMA domain.  Every
+// worker thread has a home domain, which it is bound to.  A task for
+// another domain is put on that domain's queue instead of the creating
+// thread's deque.  Threads look for work in their own domain before
+// stealing from others, and a thread running a task for another domain
+// moves there while it does so.
+//
 
 #include "chplrt.h"
 #include "chpl_rt_utils_static.h"
+#include "chpl-atomics.h"
 #include "chplcgfns.h"
 #include "chpl-comm.h"
 #include "chplexit.h"
@@ -46,7 +63,7 @@
 
 
 //
-// task pool: linked list of tasks
+// task pool: the tasks on all the threads' deques
 //
 typedef struct task_pool_struct* task_pool_p;
 
@@ -55,11 +72,10 @@ typedef struct {
 } chpl_task_prvDataImpl_t;
 
 typedef struct task_pool_struct {
-  task_pool_p*     p_list_head;  // task list we're on, if any
-  task_pool_p      list_next;    // double-link pointers for list
-  task_pool_p      list_prev;
-  task_pool_p      next;         // double-link pointers for pool
-  task_pool_p      prev;
+  task_pool_p      list_next;    // link pointer for task list, if any
+  task_pool_p      queue_next;   // link pointer for sublocale queue, if on one
+  atomic_int_least32_t started;  // has a thread claimed this task?
+  atomic_int_least32_t refs;     // deque and task list references
 
   chpl_task_prvDataImpl_t chpl_data;
 
@@ -67,6 +83,54 @@ typedef struct task_pool_struct {
 } task_pool_t;
 
 
+//
+// task deque: the tasks created by one thread
+//
+// The owning thread pushes and takes tasks at the bottom; other threads
+// steal them from the top.  When the array fills, the owner replaces it
+// with one twice as large.  Thieves may still be reading the old one,
+// so it is kept.
+//
+typedef struct task_deque_array_struct {
+  int64_t                          size;     // a power of 2
+  struct task_deque_array_struct*  prev;     // array this one replaced
+  task_pool_p volatile             tasks[];
+} task_deque_array_t;
+
+typedef struct task_deque_struct {
+  c_sublocid_t              subloc;  // owner's home sublocale
+  atomic_int_least64_t      top;     // index of the oldest task
+  atomic_int_least64_t      bottom;  // index past the newest task
+  atomic_uintptr_t          array;   // task_deque_array_t*
+  volatile int64_t          size_hint; // number of tasks, as of the owner's
+                                       //   last push or take; lets thieves
+                                       //   skip empty deques cheaply
+
+  //
+  // The owner's copies of the above, so it needn't load them
+  // atomically.  Only the owner changes bottom and array, and top only
+  // grows, so owner_top is never more than top.
+  //
+  int64_t                   owner_top;
+  int64_t                   owner_bottom;
+  task_deque_array_t*       owner_array;
+} task_deque_t;
+
+#define TASK_DEQUE_INITIAL_SIZE 64
+
+
+//
+// sublocale queue: the tasks for one sublocale that were created by a
+// thread whose home is elsewhere
+//
+typedef struct {
+  chpl_thread_mutex_t lock;
+  task_pool_p         head;
+  task_pool_p         tail;
+  volatile int32_t    cnt;   // number of tasks, read without the lock
+} subloc_queue_t;
+
+
 typedef struct lockReport {
   int32_t            filename;
   int                lineno;
@@ -80,6 +144,11 @@ typedef struct lockReport {
 typedef struct {
   task_pool_p   ptask;
   lockReport_t* lockRprt;
+  task_deque_t* deque;       // tasks this thread created, if any
+  task_deque_t* victim;      // deque this thread last stole from
+  uint64_t      steal_seed;  // for choosing where to steal from
+  c_sublocid_t  home_subloc; // sublocale whose tasks this thread prefers
+  c_sublocid_t  subloc;      // sublocale this thread is bound to now
 } thread_private_data_t;
 
 
@@ -88,24 +157,32 @@ static chpl_bool        initialized = false;
 static volatile chpl_bool canCountRunningTasks = false;
 
 static chpl_thread_mutex_t threading_lock;     // critical section lock
-static chpl_thread_mutex_t extra_task_lock;    // critical section lock
-static chpl_thread_mutex_t task_id_lock;       // critical section lock
 static chpl_thread_mutex_t task_list_lock;     // critical section lock
-static volatile task_pool_p
-                           task_pool_head;     // head of task pool
-static volatile task_pool_p
-                           task_pool_tail;     // tail of task pool
-
-static int                 queued_task_cnt;    // number of tasks in task pool
-static int                 running_task_cnt;   // number of running tasks
-static int64_t             extra_task_cnt;     // number of tasks being run by
+static task_deque_t** volatile
+                           deques;             // all deques, for stealing
+static volatile int        deque_cnt;          // number of deques
+static int                 deque_cap;          // capacity of deques[]
+
+static int                 num_sublocs;        // NUMA domains, or 0 if the
+                                               //   locale model has none
+static subloc_queue_t*     subloc_queues;      // one per sublocale
+static atomic_int_least32_t
+                           next_home_subloc;   // for spreading threads
+
+static atomic_int_least32_t
+                           queued_task_cnt;    // number of tasks in task pool
+static atomic_int_least64_t
+                           extra_task_cnt;     // number of tasks being run by
                                                //   threads occupied already
 static int                 blocked_thread_cnt; // number of threads that
                                                //   cannot make progress
-static int                 idle_thread_cnt;    // number of threads looking
+static atomic_int_least32_t
+                           idle_thread_cnt;    // number of threads looking
                                                //   for work
 static uint64_t            progress_cnt;       // number of unblock operations,
                                                //   as a proxy for progress
+static atomic_uint_least64_t
+                           next_task_id;       // next task ID to hand out
 
 static chpl_thread_mutex_t block_report_lock;   // critical section lock
 static lockReport_t* lockReportHead = NULL;
@@ -119,8 +196,22 @@ static chpl_fn_p comm_task_fn;
 //
 // Internal functions.
 //
-static void                    enqueue_task(task_pool_p, task_pool_p*);
-static void                    dequeue_task(task_pool_p);
+static chpl_bool               enqueue_task(task_pool_p, task_pool_p*);
+static chpl_bool               claim_task(task_pool_p);
+static void                    release_task(task_pool_p);
+static task_deque_t*           deque_create(c_sublocid_t);
+static task_deque_t*           get_my_deque(void);
+static void                    deque_push(task_deque_t*, task_pool_p);
+static task_pool_p             deque_take(task_deque_t*);
+static chpl_bool               deque_take_if(task_deque_t*, task_pool_p);
+static task_pool_p             deque_steal(task_deque_t*);
+static void                    subloc_queue_push(subloc_queue_t*, task_pool_p);
+static task_pool_p             subloc_queue_take(subloc_queue_t*);
+static c_sublocid_t            task_subloc(thread_private_data_t*,
+                                           task_pool_p);
+static void                    move_thread(thread_private_data_t*,
+                                           c_sublocid_t);
+static task_pool_p             find_task(thread_private_data_t*);
 static void                    comm_task_wrapper(void*);
 static void                    taskCallBody(chpl_fn_int_t, chpl_fn_p,
                                             chpl_task_bundle_t*, size_t,
@@ -140,8 +231,9 @@ static void                    check_for_deadlock(void);
 static void                    thread_begin(void*);
 static void                    thread_end(void);
 static void                    maybe_add_thread(void);
-static task_pool_p             add_to_task_pool(chpl_fn_int_t, chpl_fn_p,
+static void                    add_to_task_pool(chpl_fn_int_t, chpl_fn_p,
                                                 chpl_task_bundle_t*, size_t,
+                                                c_sublocid_t,
                                                 chpl_bool, chpl_bool, chpl_bool,
                                                 task_pool_p*, chpl_bool,
                                                 int, int32_t);
@@ -318,12 +410,15 @@ static void setup_main_thread_private_data(void)
                                            CHPL_RT_MD_TASK_POOL_DESC,
                                            0, 0);
   tp->lockRprt            = NULL;
+  tp->deque               = NULL;
+  tp->victim              = NULL;
+  tp->steal_seed          = 0;
+  tp->home_subloc         = c_sublocid_any;
+  tp->subloc              = c_sublocid_any;
 
-  tp->ptask->p_list_head  = NULL;
   tp->ptask->list_next    = NULL;
-  tp->ptask->list_prev    = NULL;
-  tp->ptask->next         = NULL;
-  tp->ptask->prev         = NULL;
+  tp->ptask->queue_next   = NULL;
+  memset(&tp->ptask->chpl_data, 0, sizeof(tp->ptask->chpl_data));
 
   // serial_state starts out true; it is set to false in chpl_std_module_init().
   tp->ptask->bundle.serial_state    = true;
@@ -345,15 +440,37 @@ static void setup_main_thread_private_data(void)
 
 void chpl_task_init(void) {
   chpl_thread_mutexInit(&threading_lock);
-  chpl_thread_mutexInit(&extra_task_lock);
-  chpl_thread_mutexInit(&task_id_lock);
   chpl_thread_mutexInit(&task_list_lock);
-  queued_task_cnt = 0;
-  running_task_cnt = 1;                     // only main task running
+  atomic_init_int_least32_t(&queued_task_cnt, 0);
   blocked_thread_cnt = 0;
-  idle_thread_cnt = 0;
-  extra_task_cnt = 0;
-  task_pool_head = task_pool_tail = NULL;
+  atomic_init_int_least32_t(&idle_thread_cnt, 0);
+  atomic_init_int_least64_t(&extra_task_cnt, 0);
+  atomic_init_uint_least64_t(&next_task_id, chpl_nullTaskID + 1);
+  deques = NULL;
+  deque_cnt = 0;
+  deque_cap = 0;
+
+  //
+  // Only the numa locale model has sublocales.  We treat each NUMA
+  // domain as one.
+  //
+  num_sublocs = 0;
+  subloc_queues = NULL;
+  atomic_init_int_least32_t(&next_home_subloc, 0);
+  if (strcmp(CHPL_LOCALE_MODEL, "numa") == 0) {
+    int i;
+
+    num_sublocs = chpl_getNumNumaDomains();
+    subloc_queues = (subloc_queue_t*)
+                      chpl_mem_allocMany(num_sublocs, sizeof(subloc_queue_t),
+                                         CHPL_RT_MD_TASK_POOL_DESC, 0, 0);
+    for (i = 0; i < num_sublocs; i++) {
+      chpl_thread_mutexInit(&subloc_queues[i].lock);
+      subloc_queues[i].head = NULL;
+      subloc_queues[i].tail = NULL;
+      subloc_queues[i].cnt = 0;
+    }
+  }
 
   chpl_thread_init(thread_begin, thread_end);
 
@@ -524,12 +641,14 @@ static void comm_task_wrapper(void* arg) {
                                            CHPL_RT_MD_TASK_POOL_DESC,
                                            0, 0);
   tp->lockRprt            = NULL;
+  tp->deque               = NULL;
+  tp->victim              = NULL;
+  tp->steal_seed          = 0;
+  tp->home_subloc         = c_sublocid_any;
+  tp->subloc              = c_sublocid_any;
 
-  tp->ptask->p_list_head  = NULL;
   tp->ptask->list_next    = NULL;
-  tp->ptask->list_prev    = NULL;
-  tp->ptask->next         = NULL;
-  tp->ptask->prev         = NULL;
+  tp->ptask->queue_next   = NULL;
 
   tp->ptask->bundle.serial_state    = false;
   tp->ptask->bundle.countRunning    = false;
@@ -548,71 +667,438 @@ static void comm_task_wrapper(void* arg) {
 
 
 //
-// Enqueue and dequeue tasks from the pool.
+// Enqueue tasks in the pool, and claim and release them.
+//
+// A task is put on the deque of the thread creating it, or on the queue
+// for its sublocale if that is not the thread's, and on its task list,
+// if any.  It holds a reference for each, which is dropped by the
+// thread that removes it from there, once that thread is done with it.
+// Whichever thread claims it first runs it; the others skip it.
+//
+// Returns true if there were other tasks on the task list.
 //
 static inline
-void enqueue_task(task_pool_p ptask, task_pool_p* p_task_list_head) {
-  queued_task_cnt++;
+chpl_bool enqueue_task(task_pool_p ptask, task_pool_p* p_task_list_head) {
+  chpl_bool more_in_list = false;
+
+  (void) atomic_fetch_add_int_least32_t(&queued_task_cnt, 1);
+
+  //
+  // Add to list, if any.
+  //
+  if (p_task_list_head != NULL) {
+    // begin critical section
+    chpl_thread_mutexLock(&task_list_lock);
+
+    ptask->list_next = *p_task_list_head;
+    *p_task_list_head = ptask;
+    more_in_list = (ptask->list_next != NULL);
+
+    // end critical section
+    chpl_thread_mutexUnlock(&task_list_lock);
+  }
 
   //
   // Add to pool.
   //
-  if (task_pool_tail)
-    task_pool_tail->next = ptask;
+  if (num_sublocs > 1 && ptask->bundle.requestedSubloc >= 0
+      && (ptask->bundle.requestedSubloc
+          != get_thread_private_data()->home_subloc))
+    subloc_queue_push(&subloc_queues[ptask->bundle.requestedSubloc], ptask);
   else
-    task_pool_head = ptask;
-  ptask->prev = task_pool_tail;
-  task_pool_tail = ptask;
+    deque_push(get_my_deque(), ptask);
+
+  return more_in_list;
+}
+
+
+static inline
+chpl_bool claim_task(task_pool_p ptask) {
+  if (atomic_load_int_least32_t(&ptask->started) != 0 ||
+      !atomic_compare_exchange_strong_int_least32_t(&ptask->started, 0, 1))
+    return false;
+
+  (void) atomic_fetch_sub_int_least32_t(&queued_task_cnt, 1);
+  return true;
+}
+
+
+static inline
+void release_task(task_pool_p ptask) {
+  if (atomic_fetch_sub_int_least32_t(&ptask->refs, 1) == 1) {
+    atomic_destroy_int_least32_t(&ptask->started);
+    atomic_destroy_int_least32_t(&ptask->refs);
+    chpl_mem_free(ptask, 0, 0);
+  }
+}
+
+
+//
+// Task deques.
+//
+static task_deque_array_t* deque_array_alloc(int64_t size) {
+  task_deque_array_t* a;
+
+  a = (task_deque_array_t*)
+        chpl_mem_alloc(sizeof(task_deque_array_t) + size * sizeof(task_pool_p),
+                       CHPL_RT_MD_TASK_POOL_DESC, 0, 0);
+  a->size = size;
+  a->prev = NULL;
+
+  return a;
+}
+
+
+static task_deque_t* deque_create(c_sublocid_t subloc) {
+  task_deque_t* d;
+
+  d = (task_deque_t*) chpl_mem_alloc(sizeof(task_deque_t),
+                                     CHPL_RT_MD_TASK_POOL_DESC, 0, 0);
+  d->subloc = subloc;
+  atomic_init_int_least64_t(&d->top, 0);
+  atomic_init_int_least64_t(&d->bottom, 0);
+  d->owner_top = 0;
+  d->owner_bottom = 0;
+  d->owner_array = deque_array_alloc(TASK_DEQUE_INITIAL_SIZE);
+  atomic_init_uintptr_t(&d->array, (uintptr_t) d->owner_array);
+  d->size_hint = 0;
 
   //
-  // Add to list, if any.
+  // Make it visible to thieves.  Deques are never removed and deques[]
+  // only grows, so thieves can read the first deque_cnt entries of it
+  // without locking.  Thieves may still be reading a replaced deques[],
+  // so it is kept.
   //
-  if (p_task_list_head == NULL) {
-    ptask->p_list_head = NULL;
-  }
-  else {
-    ptask->p_list_head = p_task_list_head;
-    ptask->list_next = *p_task_list_head;
-    if (*p_task_list_head != NULL)
-      (*p_task_list_head)->list_prev = ptask;
-    ptask->list_prev = NULL;
-    *p_task_list_head = ptask;
+  // begin critical section
+  chpl_thread_mutexLock(&threading_lock);
+
+  if (deque_cnt == deque_cap) {
+    int            new_cap = (deque_cap == 0) ? 16 : 2 * deque_cap;
+    task_deque_t** new_deques;
+
+    new_deques = (task_deque_t**) chpl_mem_allocMany(new_cap,
+                                                     sizeof(task_deque_t*),
+                                                     CHPL_RT_MD_TASK_POOL_DESC,
+                                                     0, 0);
+    if (deque_cnt > 0)
+      memcpy(new_deques, deques, deque_cnt * sizeof(task_deque_t*));
+    deque_cap = new_cap;
+    atomic_thread_fence(memory_order_release);
+    deques = new_deques;
   }
+
+  deques[deque_cnt] = d;
+  atomic_thread_fence(memory_order_release);
+  deque_cnt++;
+
+  // end critical section
+  chpl_thread_mutexUnlock(&threading_lock);
+
+  return d;
+}
+
+
+//
+// Get the deque for my thread, creating it the first time.
+//
+static task_deque_t* get_my_deque(void) {
+  thread_private_data_t* tp = get_thread_private_data();
+
+  if (tp->deque == NULL)
+    tp->deque = deque_create(tp->home_subloc);
+
+  return tp->deque;
 }
 
 
 static inline
-void dequeue_task(task_pool_p ptask) {
-  assert(queued_task_cnt > 0);
-  queued_task_cnt--;
+task_deque_array_t* deque_array(task_deque_t* d) {
+  return (task_deque_array_t*) atomic_load_uintptr_t(&d->array);
+}
+
+
+//
+// Only the owning thread may push, take, or take_if.
+//
+static void deque_push(task_deque_t* d, task_pool_p ptask) {
+  int64_t             b = d->owner_bottom;
+  task_deque_array_t* a = d->owner_array;
+
+  if (b - d->owner_top > a->size - 1) {
+    // It may only look full because thieves have taken tasks since
+    d->owner_top = atomic_load_int_least64_t(&d->top);
+  }
+
+  if (b - d->owner_top > a->size - 1) {
+    task_deque_array_t* new_a = deque_array_alloc(2 * a->size);
+    int64_t             i;
+
+    for (i = d->owner_top; i < b; i++)
+      new_a->tasks[i & (new_a->size - 1)] = a->tasks[i & (a->size - 1)];
+    new_a->prev = a;
+
+    atomic_store_uintptr_t(&d->array, (uintptr_t) new_a);
+    d->owner_array = a = new_a;
+  }
+
+  a->tasks[b & (a->size - 1)] = ptask;
+  atomic_thread_fence(memory_order_release);
+  atomic_store_int_least64_t(&d->bottom, b + 1);
+  d->owner_bottom = b + 1;
+  d->size_hint = b + 1 - d->owner_top;
+}
+
+
+static task_pool_p deque_take(task_deque_t* d) {
+  int64_t             b;
+  task_deque_array_t* a;
+  int64_t             t;
+  task_pool_p         ptask = NULL;
 
   //
-  // Remove from pool.
+  // Thieves only make the deque smaller, so if the hint says it is
+  // empty, it is.
   //
-  if (ptask == task_pool_head) {
-    if ((task_pool_head = task_pool_head->next) == NULL)
-      task_pool_tail = NULL;
-    else
-      task_pool_head->prev = NULL;
+  if (d->size_hint == 0)
+    return NULL;
+
+  b = d->owner_bottom - 1;
+  a = d->owner_array;
+
+  atomic_store_int_least64_t(&d->bottom, b);
+  atomic_thread_fence(memory_order_seq_cst);
+  t = atomic_load_int_least64_t(&d->top);
+
+  if (t <= b) {
+    ptask = a->tasks[b & (a->size - 1)];
+    if (t == b) {
+      // This is the last task, so we may be racing a thief for it.
+      if (!atomic_compare_exchange_strong_int_least64_t(&d->top, t, t + 1))
+        ptask = NULL;
+      atomic_store_int_least64_t(&d->bottom, b + 1);
+      b = b + 1;
+      t = t + 1;
+    }
   }
   else {
-    if ((ptask->prev->next = ptask->next) == NULL)
-      task_pool_tail = ptask->prev;
-    else
-      ptask->next->prev = ptask->prev;
+    atomic_store_int_least64_t(&d->bottom, b + 1);
+    b = b + 1;
+    t = b;
+  }
+
+  d->owner_top = t;
+  d->owner_bottom = b;
+  d->size_hint = b - t;
+  return ptask;
+}
+
+
+//
+// Take the given task, if it is the newest one on the deque.
+//
+static chpl_bool deque_take_if(task_deque_t* d, task_pool_p ptask) {
+  int64_t             b;
+  int64_t             t;
+  task_deque_array_t* a;
+
+  if (d->size_hint == 0)
+    return false;
+
+  b = d->owner_bottom - 1;
+  t = d->owner_top;
+  a = d->owner_array;
+
+  if (b < t || a->tasks[b & (a->size - 1)] != ptask)
+    return false;
+
+  return deque_take(d) == ptask;
+}
+
+
+//
+// Any thread may steal.  This returns NULL if the deque is empty or
+// another thread got the oldest task first.
+//
+static task_pool_p deque_steal(task_deque_t* d) {
+  int64_t             t;
+  int64_t             b;
+  task_deque_array_t* a;
+  task_pool_p         ptask;
+
+  if (d->size_hint == 0)
+    return NULL;
+
+  t = atomic_load_int_least64_t(&d->top);
+  atomic_thread_fence(memory_order_seq_cst);
+  b = atomic_load_int_least64_t(&d->bottom);
+
+  if (t >= b)
+    return NULL;
+
+  a = deque_array(d);
+  ptask = a->tasks[t & (a->size - 1)];
+
+  if (!atomic_compare_exchange_strong_int_least64_t(&d->top, t, t + 1))
+    return NULL;
+
+  return ptask;
+}
+
+
+//
+// Sublocale queues.  Any thread may push or take.
+//
+static void subloc_queue_push(subloc_queue_t* q, task_pool_p ptask) {
+  ptask->queue_next = NULL;
+
+  // begin critical section
+  chpl_thread_mutexLock(&q->lock);
+
+  if (q->tail == NULL)
+    q->head = ptask;
+  else
+    q->tail->queue_next = ptask;
+  q->tail = ptask;
+  q->cnt++;
+
+  // end critical section
+  chpl_thread_mutexUnlock(&q->lock);
+}
+
+
+static task_pool_p subloc_queue_take(subloc_queue_t* q) {
+  task_pool_p ptask;
+
+  if (q->cnt == 0)
+    return NULL;
+
+  // begin critical section
+  chpl_thread_mutexLock(&q->lock);
+
+  if ((ptask = q->head) != NULL) {
+    if ((q->head = ptask->queue_next) == NULL)
+      q->tail = NULL;
+    q->cnt--;
+  }
+
+  // end critical section
+  chpl_thread_mutexUnlock(&q->lock);
+
+  return ptask;
+}
+
+
+//
+// The sublocale the given task should run on: the one it asked for,
+// or else the running thread's home.
+//
+static inline
+c_sublocid_t task_subloc(thread_private_data_t* tp, task_pool_p ptask) {
+  c_sublocid_t subloc = ptask->bundle.requestedSubloc;
+
+  return (subloc >= 0 && subloc < num_sublocs) ? subloc : tp->home_subloc;
+}
+
+
+//
+// Bind my thread to the given sublocale, or to no particular one if
+// it is c_sublocid_any.
+//
+static inline
+void move_thread(thread_private_data_t* tp, c_sublocid_t subloc) {
+  if (num_sublocs > 1 && subloc != tp->subloc) {
+    chpl_moveToNumaDomain(subloc);
+    tp->subloc = subloc;
+  }
+}
+
+
+//
+// Find a task for my thread to run: the newest one on its own deque,
+// or the oldest one for its sublocale, or else the oldest one on
+// another thread's deque.  Deques whose owners are on the same
+// sublocale are stolen from before others, and the queues of other
+// sublocales are looked at last.  Tasks that were already claimed
+// from their task lists are skipped.
+//
+static task_pool_p find_task(thread_private_data_t* tp) {
+  task_pool_p    ptask;
+  task_deque_t** ds;
+  int            n;
+  int            start;
+  int            pass;
+  int            i;
+
+  while ((ptask = deque_take(tp->deque)) != NULL) {
+    if (claim_task(ptask))
+      return ptask;
+    release_task(ptask);
+  }
+
+  if (num_sublocs > 1 && tp->home_subloc >= 0) {
+    while ((ptask = subloc_queue_take(&subloc_queues[tp->home_subloc]))
+           != NULL) {
+      if (claim_task(ptask))
+        return ptask;
+      release_task(ptask);
+    }
   }
 
   //
-  // Remove from list, if on one.
+  // A thread that had tasks to steal probably has more.
   //
-  if (ptask->p_list_head != NULL) {
-    if (ptask == *(ptask->p_list_head))
-      *(ptask->p_list_head) = ptask->list_next;
-    else
-      ptask->list_prev->list_next = ptask->list_next;
-    if (ptask->list_next != NULL)
-      ptask->list_next->list_prev = ptask->list_prev;
+  if (tp->victim != NULL) {
+    while ((ptask = deque_steal(tp->victim)) != NULL) {
+      if (claim_task(ptask))
+        return ptask;
+      release_task(ptask);
+    }
   }
+
+  //
+  // Otherwise start looking at a random deque, so thieves spread out.
+  //
+  n = deque_cnt;
+  atomic_thread_fence(memory_order_acquire);
+  ds = deques;
+
+  tp->steal_seed ^= tp->steal_seed << 13;
+  tp->steal_seed ^= tp->steal_seed >> 7;
+  tp->steal_seed ^= tp->steal_seed << 17;
+  start = (int) (tp->steal_seed % (uint64_t) n);
+
+  for (pass = 0; pass < ((num_sublocs > 1) ? 2 : 1); pass++) {
+    for (i = 0; i < n; i++) {
+      task_deque_t* d = ds[(start + i) % n];
+      chpl_bool     near = (d->subloc == tp->home_subloc
+                            || d->subloc == c_sublocid_any);
+
+      if (d != tp->deque && d != tp->victim && near == (pass == 0)) {
+        while ((ptask = deque_steal(d)) != NULL) {
+          if (claim_task(ptask)) {
+            if (near)
+              tp->victim = d;
+            return ptask;
+          }
+          release_task(ptask);
+        }
+      }
+    }
+  }
+
+  if (num_sublocs > 1) {
+    for (i = 0; i < num_sublocs; i++) {
+      if (i != tp->home_subloc) {
+        while ((ptask = subloc_queue_take(&subloc_queues[i])) != NULL) {
+          if (claim_task(ptask))
+            return ptask;
+          release_task(ptask);
+        }
+      }
+    }
+  }
+
+  return NULL;
 }
 
 
@@ -627,21 +1113,16 @@ void chpl_task_addToTaskList(chpl_fn_int_t fid,
   task_pool_p curr_ptask = get_current_ptask();
   bool serial_state = curr_ptask->bundle.serial_state;
 
-  assert(subloc == 0 || subloc == c_sublocid_any);
-
   if (serial_state) {
     (*chpl_ftable[fid])(arg);
     return;
   }
 
-  // begin critical section
-  chpl_thread_mutexLock(&threading_lock);
-
   if (task_list_locale == chpl_nodeID) {
-    (void) add_to_task_pool(fid, chpl_ftable[fid], arg, arg_size,
-                            false, false, false,
-                            (task_pool_p*) p_task_list_void, is_begin_stmt,
-                            lineno, filename);
+    add_to_task_pool(fid, chpl_ftable[fid], arg, arg_size, subloc,
+                     false, false, false,
+                     (task_pool_p*) p_task_list_void, is_begin_stmt,
+                     lineno, filename);
 
   }
   else {
@@ -651,20 +1132,20 @@ void chpl_task_addToTaskList(chpl_fn_int_t fid,
     // the context of a cobegin or coforall statement.
     //
     assert(is_begin_stmt);
-    (void) add_to_task_pool(fid, chpl_ftable[fid], arg, arg_size,
-                            false, false, false,
-                            NULL, true, 0, CHPL_FILE_IDX_UNKNOWN);
+    add_to_task_pool(fid, chpl_ftable[fid], arg, arg_size, subloc,
+                     false, false, false,
+                     NULL, true, 0, CHPL_FILE_IDX_UNKNOWN);
   }
-
-  // end critical section
-  chpl_thread_mutexUnlock(&threading_lock);
 }
 
 
 void chpl_task_executeTasksInList(void** p_task_list_void) {
   task_pool_p* p_task_list_head = (task_pool_p*) p_task_list_void;
+  thread_private_data_t* tp;
   task_pool_p curr_ptask;
   task_pool_p child_ptask;
+  task_pool_p next_ptask;
+  c_sublocid_t curr_subloc;
 
   //
   // If we're serial, all the tasks have already been executed.
@@ -672,85 +1153,90 @@ void chpl_task_executeTasksInList(void** p_task_list_void) {
   if (chpl_task_getSerial())
     return;
 
-  curr_ptask = get_current_ptask();
+  tp = get_thread_private_data();
+  curr_ptask = tp->ptask;
+  curr_subloc = tp->subloc;
 
   while (*p_task_list_head != NULL) {
-    chpl_fn_p task_to_run_fun = NULL;
+    //
+    // Take the whole list.  Other tasks sharing our end count may add
+    // to it meanwhile; we get those next time around.
+    //
 
     // begin critical section
-    chpl_thread_mutexLock(&threading_lock);
+    chpl_thread_mutexLock(&task_list_lock);
 
-    if ((child_ptask = *p_task_list_head) != NULL) {
-      task_to_run_fun = child_ptask->bundle.requested_fn;
-      dequeue_task(child_ptask);
-    }
+    next_ptask = *p_task_list_head;
+    *p_task_list_head = NULL;
 
     // end critical section
-    chpl_thread_mutexUnlock(&threading_lock);
-
-    if (task_to_run_fun == NULL)
-      continue;
+    chpl_thread_mutexUnlock(&task_list_lock);
 
-    set_current_ptask(child_ptask);
+    while ((child_ptask = next_ptask) != NULL) {
+      next_ptask = child_ptask->list_next;
 
-    // begin critical section
-    chpl_thread_mutexLock(&extra_task_lock);
-
-    extra_task_cnt++;
-
-    // end critical section
-    chpl_thread_mutexUnlock(&extra_task_lock);
+      //
+      // Usually the task is still the newest one on our deque.  If so,
+      // remove it so that no thread has to skip over it later.
+      //
+      if (tp->deque != NULL && deque_take_if(tp->deque, child_ptask))
+        release_task(child_ptask);
 
-    if (do_taskReport) {
-      chpl_thread_mutexLock(&taskTable_lock);
-      chpldev_taskTable_set_suspended(curr_ptask->bundle.id);
-      chpldev_taskTable_set_active(child_ptask->bundle.id);
-      chpl_thread_mutexUnlock(&taskTable_lock);
-    }
+      if (!claim_task(child_ptask)) {
+        release_task(child_ptask);
+        continue;
+      }
 
-    if (blockreport)
-      initializeLockReportForThread();
+      set_current_ptask(child_ptask);
+      move_thread(tp, task_subloc(tp, child_ptask));
 
-    chpl_task_do_callbacks(chpl_task_cb_event_kind_begin,
-                           child_ptask->bundle.requested_fid,
-                           child_ptask->bundle.filename,
-                           child_ptask->bundle.lineno,
-                           child_ptask->bundle.id,
-                           child_ptask->bundle.is_executeOn);
+      (void) atomic_fetch_add_int_least64_t(&extra_task_cnt, 1);
 
-    if (child_ptask->bundle.countRunning)
-        chpl_taskRunningCntInc(0, 0);
+      if (do_taskReport) {
+        chpl_thread_mutexLock(&taskTable_lock);
+        chpldev_taskTable_set_suspended(curr_ptask->bundle.id);
+        chpldev_taskTable_set_active(child_ptask->bundle.id);
+        chpl_thread_mutexUnlock(&taskTable_lock);
+      }
 
-    (*task_to_run_fun)(&child_ptask->bundle);
+      if (blockreport)
+        initializeLockReportForThread();
 
-    if (child_ptask->bundle.countRunning)
-        chpl_taskRunningCntDec(0, 0);
+      chpl_task_do_callbacks(chpl_task_cb_event_kind_begin,
+                             child_ptask->bundle.requested_fid,
+                             child_ptask->bundle.filename,
+                             child_ptask->bundle.lineno,
+                             child_ptask->bundle.id,
+                             child_ptask->bundle.is_executeOn);
 
-    chpl_task_do_callbacks(chpl_task_cb_event_kind_end,
-                           child_ptask->bundle.requested_fid,
-                           child_ptask->bundle.filename,
-                           child_ptask->bundle.lineno,
-                           child_ptask->bundle.id,
-                           child_ptask->bundle.is_executeOn);
+      if (child_ptask->bundle.countRunning)
+          chpl_taskRunningCntInc(0, 0);
 
-    if (do_taskReport) {
-      chpl_thread_mutexLock(&taskTable_lock);
-      chpldev_taskTable_set_active(curr_ptask->bundle.id);
-      chpldev_taskTable_remove(child_ptask->bundle.id);
-      chpl_thread_mutexUnlock(&taskTable_lock);
-    }
+      (*child_ptask->bundle.requested_fn)(&child_ptask->bundle);
 
-    // begin critical section
-    chpl_thread_mutexLock(&extra_task_lock);
+      if (child_ptask->bundle.countRunning)
+          chpl_taskRunningCntDec(0, 0);
 
-    extra_task_cnt--;
+      chpl_task_do_callbacks(chpl_task_cb_event_kind_end,
+                             child_ptask->bundle.requested_fid,
+                             child_ptask->bundle.filename,
+                             child_ptask->bundle.lineno,
+                             child_ptask->bundle.id,
+                             child_ptask->bundle.is_executeOn);
 
-    // end critical section
-    chpl_thread_mutexUnlock(&extra_task_lock);
+      if (do_taskReport) {
+        chpl_thread_mutexLock(&taskTable_lock);
+        chpldev_taskTable_set_active(curr_ptask->bundle.id);
+        chpldev_taskTable_remove(child_ptask->bundle.id);
+        chpl_thread_mutexUnlock(&taskTable_lock);
+      }
 
-    set_current_ptask(curr_ptask);
-    chpl_mem_free(child_ptask, 0, 0);
+      (void) atomic_fetch_sub_int_least64_t(&extra_task_cnt, 1);
 
+      move_thread(tp, curr_subloc);
+      set_current_ptask(curr_ptask);
+      release_task(child_ptask);
+    }
   }
 }
 
@@ -768,15 +1254,9 @@ void taskCallBody(chpl_fn_int_t fid, chpl_fn_p fp,
                   chpl_task_bundle_t* arg, size_t arg_size,
                   c_sublocid_t subloc, chpl_bool serial_state,
                   int lineno, int32_t filename) {
-  // begin critical section
-  chpl_thread_mutexLock(&threading_lock);
-
-  (void) add_to_task_pool(fid, fp, arg, arg_size,
-                          serial_state, canCountRunningTasks, true,
-                          NULL, false, lineno, filename);
-
-  // end critical section
-  chpl_thread_mutexUnlock(&threading_lock);
+  add_to_task_pool(fid, fp, arg, arg_size, subloc,
+                   serial_state, canCountRunningTasks, true,
+                   NULL, false, lineno, filename);
 }
 
 
@@ -799,19 +1279,31 @@ void chpl_task_startMovedTask(chpl_fn_int_t  fid, chpl_fn_p fp,
 }
 
 
-//
-// chpl_task_getSubloc() is in tasks-fifo.h.
-//
+c_sublocid_t chpl_task_getSubloc(void) {
+  c_sublocid_t subloc = get_thread_private_data()->subloc;
 
+  return (subloc >= 0) ? subloc : 0;
+}
 
-//
-// chpl_task_setSubloc() is in tasks-fifo.h.
-//
 
+void chpl_task_setSubloc(c_sublocid_t subloc) {
+  thread_private_data_t* tp;
 
-//
-// chpl_task_getRequestedSubloc() is in tasks-fifo.h.
-//
+  assert(subloc != c_sublocid_none);
+
+  if (num_sublocs == 0)
+    return;
+
+  tp = get_thread_private_data();
+  tp->ptask->bundle.requestedSubloc = (subloc < num_sublocs)
+                                      ? subloc : c_sublocid_any_val;
+  move_thread(tp, task_subloc(tp, tp->ptask));
+}
+
+
+c_sublocid_t chpl_task_getRequestedSubloc(void) {
+  return get_current_ptask()->bundle.requestedSubloc;
+}
 
 
 chpl_taskID_t chpl_task_getId(void) {
@@ -875,7 +1367,7 @@ uint32_t chpl_task_getMaxPar(void) {
 }
 
 c_sublocid_t chpl_task_getNumSublocales(void) {
-  return 0;
+  return num_sublocs;
 }
 
 chpl_task_prvData_t* chpl_task_getPrvData(void) {
@@ -886,7 +1378,9 @@ size_t chpl_task_getCallStackSize(void) {
   return chpl_thread_getCallStackSize();
 }
 
-uint32_t chpl_task_getNumQueuedTasks(void) { return queued_task_cnt; }
+uint32_t chpl_task_getNumQueuedTasks(void) {
+  return atomic_load_int_least32_t(&queued_task_cnt);
+}
 
 uint32_t chpl_task_getNumRunningTasks(void) {
   chpl_internal_error("chpl_task_getNumRunningTasks() called");
@@ -898,14 +1392,13 @@ int32_t  chpl_task_getNumBlockedTasks(void) {
     int numBlockedTasks;
 
     // begin critical section
-    chpl_thread_mutexLock(&threading_lock);
     chpl_thread_mutexLock(&block_report_lock);
 
-    numBlockedTasks = blocked_thread_cnt - idle_thread_cnt;
+    numBlockedTasks = blocked_thread_cnt
+                      - atomic_load_int_least32_t(&idle_thread_cnt);
 
     // end critical section
     chpl_thread_mutexUnlock(&block_report_lock);
-    chpl_thread_mutexUnlock(&threading_lock);
 
     assert(numBlockedTasks >= 0);
     return numBlockedTasks;
@@ -921,15 +1414,7 @@ int32_t  chpl_task_getNumBlockedTasks(void) {
 // Get a new task ID.
 //
 static chpl_taskID_t get_next_task_id(void) {
-  static chpl_taskID_t       id = chpl_nullTaskID + 1;
-
-  chpl_taskID_t              next_id;
-
-  chpl_thread_mutexLock(&task_id_lock);
-  next_id = id++;
-  chpl_thread_mutexUnlock(&task_id_lock);
-
-  return next_id;
+  return atomic_fetch_add_uint_least64_t(&next_task_id, 1);
 }
 
 
@@ -995,17 +1480,38 @@ static void report_locked_threads(void) {
 // pending tasks and those that are running.
 //
 static void report_all_tasks(void) {
-  task_pool_p pendingTask = task_pool_head;
+  int           n = deque_cnt;
+  int           j;
 
   printf("Task report\n");
   printf("--------------------------------\n");
 
   // print out pending tasks
   printf("Pending tasks:\n");
-  while (pendingTask != NULL) {
-    printf("- %s:%d\n", chpl_lookupFilename(pendingTask->bundle.filename),
-           pendingTask->bundle.lineno);
-    pendingTask = pendingTask->next;
+  for (j = 0; j < n; j++) {
+    task_deque_t*       d = deques[j];
+    task_deque_array_t* a = deque_array(d);
+    int64_t             b = atomic_load_int_least64_t(&d->bottom);
+    int64_t             i;
+
+    for (i = atomic_load_int_least64_t(&d->top); i < b; i++) {
+      task_pool_p pendingTask = a->tasks[i & (a->size - 1)];
+
+      if (atomic_load_int_least32_t(&pendingTask->started) == 0)
+        printf("- %s:%d\n", chpl_lookupFilename(pendingTask->bundle.filename),
+               pendingTask->bundle.lineno);
+    }
+  }
+  for (j = 0; j < num_sublocs; j++) {
+    task_pool_p pendingTask;
+
+    for (pendingTask = subloc_queues[j].head;
+         pendingTask != NULL;
+         pendingTask = pendingTask->queue_next) {
+      if (atomic_load_int_least32_t(&pendingTask->started) == 0)
+        printf("- %s:%d\n", chpl_lookupFilename(pendingTask->bundle.filename),
+               pendingTask->bundle.lineno);
+    }
   }
   printf("\n");
 
@@ -1170,6 +1676,21 @@ thread_begin(void* ptask_void) {
   if (blockreport)
     initializeLockReportForThread();
 
+  //
+  // Spread the threads evenly over the sublocales, if any.
+  //
+  tp->home_subloc = c_sublocid_any;
+  tp->subloc = c_sublocid_any;
+  if (num_sublocs > 1) {
+    tp->home_subloc = atomic_fetch_add_int_least32_t(&next_home_subloc, 1)
+                      % num_sublocs;
+    move_thread(tp, tp->home_subloc);
+  }
+
+  tp->deque = deque_create(tp->home_subloc);
+  tp->victim = NULL;
+  tp->steal_seed = ((uint64_t) (intptr_t) tp) | 1;
+
   while (true) {
     //
     // wait for a task to be present in the task pool
@@ -1185,7 +1706,7 @@ thread_begin(void* ptask_void) {
     // that were waiting on the signal, but since there was a performance
     // impact from keeping it as a hybrid as opposed to merely yielding,
     // it was decided that we would return to the simple yield case.
-    while (!task_pool_head) {
+    while (atomic_load_int_least32_t(&queued_task_cnt) == 0) {
       if (set_block_loc(0, CHPL_FILE_IDX_IDLE_TASK)) {
         // all other tasks appear to be blocked
         struct timeval deadline, now;
@@ -1193,32 +1714,32 @@ thread_begin(void* ptask_void) {
         deadline.tv_sec += 1;
         do {
           chpl_thread_yield();
-          if (!task_pool_head)
+          if (atomic_load_int_least32_t(&queued_task_cnt) == 0)
             gettimeofday(&now, NULL);
-        } while (!task_pool_head
+        } while (atomic_load_int_least32_t(&queued_task_cnt) == 0
                  && (now.tv_sec < deadline.tv_sec
                      || (now.tv_sec == deadline.tv_sec
                          && now.tv_usec < deadline.tv_usec)));
-        if (!task_pool_head) {
+        if (atomic_load_int_least32_t(&queued_task_cnt) == 0) {
           check_for_deadlock();
         }
       }
       else {
         do {
           chpl_thread_yield();
-        } while (!task_pool_head);
+        } while (atomic_load_int_least32_t(&queued_task_cnt) == 0);
       }
 
       unset_block_loc();
     }
  
     //
-    // Just now the pool had at least one task in it.  Lock and see if
-    // there's something still there.
+    // Just now the pool had at least one task in it.  See if we can
+    // claim one.  If not, the thread adding it may not have finished
+    // doing so, so give it a chance to.
     //
-    chpl_thread_mutexLock(&threading_lock);
-    if (!task_pool_head) {
-      chpl_thread_mutexUnlock(&threading_lock);
+    if ((ptask = find_task(tp)) == NULL) {
+      chpl_thread_yield();
       continue;
     }
 
@@ -1230,21 +1751,14 @@ thread_begin(void* ptask_void) {
       progress_cnt++;
 
     //
-    // start new task; increment running count and remove task from pool
-    // also add to task to task-table (structure in ChapelRuntime that keeps
-    // track of currently running tasks for task-reports on deadlock or
-    // Ctrl+C).
+    // start new task; decrement idle count and add to task to task-table
+    // (structure in ChapelRuntime that keeps track of currently running
+    // tasks for task-reports on deadlock or Ctrl+C).
     //
-    ptask = task_pool_head;
-    idle_thread_cnt--;
-    running_task_cnt++;
-
-    dequeue_task(ptask);
-
-    // end critical section
-    chpl_thread_mutexUnlock(&threading_lock);
+    (void) atomic_fetch_sub_int_least32_t(&idle_thread_cnt, 1);
 
     tp->ptask = ptask;
+    move_thread(tp, task_subloc(tp, ptask));
 
     if (do_taskReport) {
       chpl_thread_mutexLock(&taskTable_lock);
@@ -1281,20 +1795,13 @@ thread_begin(void* ptask_void) {
     }
 
     tp->ptask = NULL;
-    chpl_mem_free(ptask, 0, 0);
-
-    // begin critical section
-    chpl_thread_mutexLock(&threading_lock);
+    release_task(ptask);
+    move_thread(tp, tp->home_subloc);
 
     //
-    // finished task; decrement running count and increment idle count
+    // finished task; increment idle count
     //
-    assert(running_task_cnt > 0);
-    running_task_cnt--;
-    idle_thread_cnt++;
-
-    // end critical section
-    chpl_thread_mutexUnlock(&threading_lock);
+    (void) atomic_fetch_add_int_least32_t(&idle_thread_cnt, 1);
   }
 }
 
@@ -1322,11 +1829,23 @@ static void thread_end(void)
 // Launch another thread, if it seems useful to do so and we can.
 //
 static void maybe_add_thread(void) {
-  static chpl_bool warning_issued = false;
+  static volatile chpl_bool warning_issued = false;
+
+  if (warning_issued || !chpl_thread_canCreate())
+    return;
 
-  if (!warning_issued && chpl_thread_canCreate()) {
+  // begin critical section
+  chpl_thread_mutexLock(&threading_lock);
+
+  //
+  // Other threads may have added threads or started tasks since our
+  // caller looked, so check again.
+  //
+  if (!warning_issued && chpl_thread_canCreate()
+      && (atomic_load_int_least32_t(&queued_task_cnt)
+          > atomic_load_int_least32_t(&idle_thread_cnt))) {
     if (chpl_thread_create(NULL) == 0) {
-      idle_thread_cnt++;
+      (void) atomic_fetch_add_int_least32_t(&idle_thread_cnt, 1);
     }
     else {
       int32_t max_threads = chpl_thread_getMaxThreads();
@@ -1346,26 +1865,30 @@ static void maybe_add_thread(void) {
       warning_issued = true;
     }
   }
+
+  // end critical section
+  chpl_thread_mutexUnlock(&threading_lock);
 }
 
 
 // create a task from the given function pointer and arguments
-// and append it to the end of the task pool
-// assumes threading_lock has already been acquired!
+// and push it on this thread's deque in the task pool
 static inline
-task_pool_p add_to_task_pool(chpl_fn_int_t fid, chpl_fn_p fp,
-                             chpl_task_bundle_t* a, size_t a_size,
-                             chpl_bool serial_state,
-                             chpl_bool countRunningTasks,
-                             chpl_bool is_executeOn,
-                             task_pool_p* p_task_list_head,
-                             chpl_bool is_begin_stmt,
-                             int lineno, int32_t filename) {
+void add_to_task_pool(chpl_fn_int_t fid, chpl_fn_p fp,
+                      chpl_task_bundle_t* a, size_t a_size,
+                      c_sublocid_t subloc,
+                      chpl_bool serial_state,
+                      chpl_bool countRunningTasks,
+                      chpl_bool is_executeOn,
+                      task_pool_p* p_task_list_head,
+                      chpl_bool is_begin_stmt,
+                      int lineno, int32_t filename) {
 
 
   size_t payload_size;
   task_pool_p ptask;
   chpl_task_prvDataImpl_t pv;
+  chpl_bool more_in_list;
 
   memset(&pv, 0, sizeof(pv));
 
@@ -1378,24 +1901,28 @@ task_pool_p add_to_task_pool(chpl_fn_int_t fid, chpl_fn_p fp,
 
   memcpy(&ptask->bundle, a, a_size);
 
-  ptask->p_list_head            = NULL;
   ptask->list_next              = NULL;
-  ptask->list_prev              = NULL;
-  ptask->next                   = NULL;
-  ptask->prev                   = NULL;
+  ptask->queue_next             = NULL;
   ptask->chpl_data              = pv;
   ptask->bundle.serial_state    = serial_state;
   ptask->bundle.countRunning    = countRunningTasks;
   ptask->bundle.is_executeOn    = is_executeOn;
   ptask->bundle.lineno          = lineno;
   ptask->bundle.filename        = filename;
-  ptask->bundle.requestedSubloc = c_sublocid_any_val;
+  ptask->bundle.requestedSubloc = (subloc >= 0 && subloc < num_sublocs)
+                                  ? subloc : c_sublocid_any_val;
   ptask->bundle.requested_fid   = fid;
   ptask->bundle.requested_fn    = fp;
   ptask->bundle.id              = get_next_task_id();
 
-  enqueue_task(ptask, p_task_list_head);
+  atomic_init_int_least32_t(&ptask->started, 0);
+  atomic_init_int_least32_t(&ptask->refs,
+                            (p_task_list_head == NULL) ? 1 : 2);
 
+  //
+  // Once the task is enqueued another thread may run and free it, so
+  // do everything else with it first.
+  //
   chpl_task_do_callbacks(chpl_task_cb_event_kind_create,
                          ptask->bundle.requested_fid,
                          ptask->bundle.filename,
@@ -1411,18 +1938,19 @@ task_pool_p add_to_task_pool(chpl_fn_int_t fid, chpl_fn_p fp,
     chpl_thread_mutexUnlock(&taskTable_lock);
   }
 
+  more_in_list = enqueue_task(ptask, p_task_list_head);
+
   //
   // If we now have more tasks than threads to run them on (taking
   // into account that the current parent of a structured parallel
   // construct can run at least one of that construct's children),
   // try to start another thread.
   //
-  if (queued_task_cnt > idle_thread_cnt &&
-      (p_task_list_head == NULL || ptask->list_next != NULL || is_begin_stmt)) {
+  if (atomic_load_int_least32_t(&queued_task_cnt)
+        > atomic_load_int_least32_t(&idle_thread_cnt) &&
+      (p_task_list_head == NULL || more_in_list || is_begin_stmt)) {
     maybe_add_thread();
   }
-
-  return ptask;
 }
 
 
@@ -1433,5 +1961,5 @@ uint32_t chpl_task_getNumThreads(void) {
 }
 
 uint32_t chpl_task_getNumIdleThreads(void) {
-  return idle_thread_cnt;
+  return atomic_load_int_least32_t(&idle_thread_cnt);
 }
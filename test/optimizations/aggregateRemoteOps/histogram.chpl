@@ -0,0 +1,26 @@
+use BlockDist;
+
+config const n = 1000;
+config const m = 64;
+
+const D     = {1..n} dmapped Block({1..n});
+const HistD = {0..m-1} dmapped Block({0..m-1});
+
+var B: [D] int;
+var Hist: [HistD] int;
+var Scatter: [D] int;
+
+forall i in D do
+  B[i] = (i * 7919) % m;
+
+// Each element is written by one iteration only, so the PUTs may be buffered
+forall i in D do
+  Scatter[n + 1 - i] = i;
+
+forall i in HistD do
+  Hist[i] = i * 2;
+
+writeln(+ reduce Scatter);
+writeln(Scatter[1], " ", Scatter[n]);
+writeln(+ reduce Hist);
+writeln(B[1], " ", B[n]);
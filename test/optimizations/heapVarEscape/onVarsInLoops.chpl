@@ -0,0 +1,57 @@
+// Locals used by 'on' statements are heap allocated.  Those declared in a
+// loop whose tasks are all joined within an iteration share one heap cell.
+
+config const n = 5;
+
+var sum = 0;
+for i in 1..n {
+  var x = i;
+  on Locales[numLocales-1] do x *= 2;
+  sum += x;
+}
+writeln(sum);
+
+// A break leaves the loop
+sum = 0;
+for i in 1..n {
+  var x = i;
+  on Locales[numLocales-1] do x += 1;
+  if x > 3 then break;
+  sum += x;
+}
+writeln(sum);
+
+// Nested loops
+sum = 0;
+for i in 1..n {
+  for j in 1..i {
+    var x: int;
+    on Locales[numLocales-1] do x = i * j;
+    sum += x;
+  }
+}
+writeln(sum);
+
+// A begin joined by a sync in the iteration
+sum = 0;
+for i in 1..n {
+  var x = i;
+  sync {
+    begin with (ref x) {
+      on Locales[numLocales-1] do x += 100;
+    }
+  }
+  sum += x;
+}
+writeln(sum);
+
+// Each task of a coforall has its own
+var total: atomic int;
+coforall t in 1..n {
+  for i in 1..t {
+    var x = t;
+    on Locales[numLocales-1] do x += i;
+    total.add(x);
+  }
+}
+writeln(total.read());
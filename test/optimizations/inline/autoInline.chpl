@@ -0,0 +1,47 @@
+// Small functions are inlined without being declared inline
+
+config const n = 10;
+
+var g = 1;
+
+proc smallSquare(x: int) return x * x;
+
+// The value formal must keep the value it was passed
+proc aliasRead(ref r: int, x: int) {
+  r = 5;
+  return x;
+}
+
+proc recursiveSum(i: int): int {
+  if i <= 0 then return 0;
+  return i + recursiveSum(i - 1);
+}
+
+proc largeBody(x: int) {
+  var s = x;
+  for i in 1..x {
+    s += i * i;
+    s -= i / 2;
+    s += i % 3;
+    s *= 2;
+    s /= 2;
+    if s > 1000 then s = s - 1000;
+    if s < 0 then s = -s;
+    s += i * 3;
+    s -= i / 5;
+    s += i % 7;
+    s += i * 5;
+    s -= i / 9;
+  }
+  return s;
+}
+
+var sum = 0;
+
+for i in 1..n do
+  sum += smallSquare(i);
+
+writeln(sum);
+writeln(aliasRead(g, g), " ", g);
+writeln(recursiveSum(n));
+writeln(largeBody(n));
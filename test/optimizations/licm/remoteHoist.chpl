@@ -0,0 +1,36 @@
+// Reads of class fields that are only set by the constructor may be hoisted
+// out of a loop even though the loop passes the instance to a call.  The
+// field that 'bump' writes must still be read in every iteration.
+
+class Desc {
+  const lo: int;
+  const hi: int;
+  var   count: int;
+}
+
+proc bump(d: Desc) {
+  d.count += 1;
+}
+
+proc sumBounds(d: Desc, n: int) {
+  var sum = 0;
+
+  for i in 1..n {
+    bump(d);
+    sum += d.lo + d.hi + d.count;
+  }
+
+  return sum;
+}
+
+proc main() {
+  var d = new Desc(3, 7);
+
+  on Locales[numLocales-1] {
+    writeln(sumBounds(d, 10));
+  }
+
+  writeln(d.count);
+
+  delete d;
+}
@@ -0,0 +1,31 @@
+//
+// The const fields of d are read at the start of the first on-statement
+// and travel with the task, while count is still read remotely.  The
+// second on-statement runs where d lives and is left alone.
+//
+class Desc {
+  const lo: int;
+  const hi: int;
+  var   count: int;
+}
+
+proc main() {
+  var d = new Desc(3, 7);
+
+  on Locales[numLocales-1] {
+    const lo = d.lo;
+    const hi = d.hi;
+
+    writeln(lo..hi);
+
+    d.count += 1;
+  }
+
+  on d {
+    writeln(d.lo + d.hi);
+  }
+
+  writeln(d.count);
+
+  delete d;
+}
@@ -0,0 +1,56 @@
+// Small records passed to and returned from functions are passed as their
+// fields.  The results must not change.  Inlining is disabled so that the
+// calls remain.
+
+config const n = 20;
+
+var A: [0..n] real;
+for i in 0..n do A[i] = i;
+
+proc interior(r: range, k: int) {
+  return r.low+k..r.high-k;
+}
+
+proc sumOver(r: range) {
+  var s = 0.0;
+  for i in r do s += A[i];
+  return s;
+}
+
+proc lowPlusHigh(r: range) {
+  return r.low + r.high;
+}
+
+proc shifted(t: 2*int) {
+  return (t(1)+1, t(2)+2);
+}
+
+proc swapped(t: 2*int) {
+  return (t(2), t(1));
+}
+
+var total = 0.0;
+for k in 1..3 {
+  const r = interior(0..n, k);
+  total += sumOver(r);
+}
+writeln(total);
+
+// the actual is changed after the call
+proc changeActual() {
+  var r = 1..n;
+  const before = lowPlusHigh(r);
+  r = 2..n;
+  writeln(before, " ", lowPlusHigh(r));
+}
+changeActual();
+
+var t = (1, 2);
+for 1..3 do t = shifted(t);
+writeln(t);
+t = swapped(t);
+writeln(t);
+
+// the result is discarded
+swapped(t);
+writeln(t);
@@ -0,0 +1,46 @@
+config const n = 10;
+
+record counter {
+  var hits: int;
+  var total: int;
+}
+
+proc ref counter.bump(x: int) {
+  hits += 1;
+  addTo(x);
+}
+
+proc ref counter.addTo(x: int) {
+  total += scale(x);
+}
+
+proc scale(x: int) {
+  return twice(x) + 1;
+}
+
+proc twice(x: int) {
+  return x + x;
+}
+
+proc fact(x: int): int {
+  if x <= 1 then return 1;
+  return x * fact(x-1);
+}
+
+var c: counter;
+var f: int;
+
+on Locales(numLocales-1) {
+  local {
+    c.bump(n);
+  }
+}
+
+on Locales(numLocales-1) {
+  local {
+    f = fact(5);
+  }
+}
+
+writeln(c);
+writeln(f);
@@ -0,0 +1,22 @@
+class Foo {
+  var x: int;
+}
+
+proc show(f: Foo) {
+  writeln(f.x, " ", __primitive("is wide pointer", f));
+}
+
+proc main() {
+  var loc = new Foo(1);
+  var remote: Foo;
+
+  on Locales[numLocales-1] do remote = new Foo(2);
+
+  // Only the call that passes a remote object needs a wide formal
+  show(loc);
+  show(loc);
+  show(remote);
+
+  delete loc;
+  delete remote;
+}